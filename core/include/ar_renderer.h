@@ -6,6 +6,7 @@
 #pragma once
 
 #include "garment_converter.h"
+#include "pose_latch.h"
 #include "types.h"
 #include <memory>
 #include <vector>
@@ -26,6 +27,11 @@ struct RenderConfig {
   // Lighting
   Point3D lightDirection = {0.5f, -1.0f, 0.5f};
   float ambientLight = 0.3f;
+
+  // Late latching: shift rigged garment vertices by the motion between the
+  // simulated pose and the newest latched pose just before rasterization
+  bool enableLateLatch = true;
+  float maxLateLatchCorrection = 0.2f; // Larger landmark jumps are not corrected
 };
 
 /**
@@ -92,6 +98,39 @@ public:
   void setBodyOcclusionMesh(const std::vector<Point3D> &bodyMesh,
                             const Transform &transform);
 
+  /**
+   * @brief Set the pose the current garment meshes were simulated against
+   *
+   * Late latching compares poses on the measured time base: a latched pose
+   * newer than the measured pose is extrapolated to the display time with
+   * the motion the prediction assumed, and only its difference from the
+   * predicted pose is corrected.
+   *
+   * @param measuredPose Tracked pose the prediction started from
+   * @param captureTime Capture time of measuredPose, in seconds
+   * @param simulatedPose Pose the collision body was built from (the
+   *                      display-time prediction, or measuredPose)
+   * @param displayTime Time simulatedPose represents, in seconds
+   */
+  void setSimulationPose(const BodyPose &measuredPose, float captureTime,
+                         const BodyPose &simulatedPose, float displayTime);
+
+  /**
+   * @brief Set an unpredicted simulation pose (measured and simulated are the same)
+   */
+  void setSimulationPose(const BodyPose &pose, float timestamp) {
+    setSimulationPose(pose, timestamp, pose, timestamp);
+  }
+
+  /**
+   * @brief Read the newest tracked pose from this latch right before rasterizing
+   *
+   * When the latch holds a pose newer than the simulation pose, each rigged
+   * garment vertex is translated by the bone-weighted landmark motion since
+   * the simulation pose. Physics is not re-run.
+   */
+  void setPoseLatch(std::shared_ptr<PoseLatch> latch);
+
   /**
    * @brief Render current frame
    * @return Rendered output image
@@ -107,13 +146,18 @@ public:
 
   /**
    * @brief Set camera projection matrix
-   * @param projection 4x4 projection matrix
+   *
+   * Once a projection or view matrix is set, garments are projected with
+   * projection * view instead of the built-in perspective, and late-latch
+   * corrections are unprojected through its inverse.
+   *
+   * @param projection 4x4 projection matrix (column-major)
    */
   void setProjectionMatrix(const Transform &projection);
 
   /**
    * @brief Set camera view matrix
-   * @param view 4x4 view matrix
+   * @param view 4x4 view matrix (column-major)
    */
   void setViewMatrix(const Transform &view);
 
@@ -11,6 +11,7 @@
 #include "body_tracker.h"
 #include "garment_converter.h"
 #include "physics_engine.h"
+#include "pose_predictor.h"
 #include "types.h"
 
 #include <functional>
@@ -35,6 +36,11 @@ using PoseCallback = std::function<void(const BodyPose &pose)>;
 using ErrorCallback =
     std::function<void(ErrorCode code, const std::string &message)>;
 
+/**
+ * @brief 非同期の衣服読み込み完了時のコールバック（作業スレッドから呼ばれる）
+ */
+using GarmentLoadCallback = std::function<void(const Result<std::string> &garmentId)>;
+
 /**
  * @brief ARFitKit SDK メインクラス
  *
@@ -100,6 +106,16 @@ public:
    */
   Result<std::string> loadGarmentFromUrl(const std::string &url);
 
+  /**
+   * @brief URLから衣服を非同期で読み込む（呼び出し元をブロックしない）
+   *
+   * 同じURLの読み込みが進行中なら、サーバーへの要求は1回にまとめられます。
+   *
+   * @param url 衣服画像のURL
+   * @param callback 読み込まれた衣服のIDを受け取るコールバック
+   */
+  void loadGarmentFromUrlAsync(const std::string &url, GarmentLoadCallback callback);
+
   /**
    * @brief 衣服を試着する
    * @param garmentId 試着する衣服のID
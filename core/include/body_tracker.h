@@ -5,12 +5,16 @@
 
 #pragma once
 
+#include "segmentation_mask.h"
 #include "types.h"
 #include <memory>
 #include <vector>
 
 namespace arfit {
 
+class IPoseEstimator;
+class PoseLatch;
+
 /**
  * @brief Configuration for body tracking
  */
@@ -18,10 +22,48 @@ struct BodyTrackerConfig {
   float minDetectionConfidence = 0.5f;
   float minTrackingConfidence = 0.5f;
   bool enableSegmentation = false;
+  int segmentationDownscale = 4; // Frame pixels per mask pixel along each axis
+  MaskFormat segmentationFormat = MaskFormat::UINT8;
+  bool segmentationRunLength = false; // Also fill BodyTrackingResult::segmentationRuns
   bool smoothLandmarks = true;
+  float smoothingMinCutoff = 1.0f; // One-Euro cutoff in Hz when still (lower = less jitter)
+  float smoothingBeta = 10.0f;     // Cutoff increase per normalized unit/s (higher = less lag)
   int numPoses = 1; // Number of people to track
+  float maxAssociationDistance = 0.25f; // Mean landmark distance for matching a detection to a track
+  int maxMissedKeyframes = 3;           // Keyframes a track survives without a matching detection
+
+  // SMPL fitting (Levenberg-Marquardt, warm-started from the previous frame)
+  int fitMaxIterations = 8;
+  float fitTimeBudgetMs = 2.0f; // Per person per frame
+
+  // Pose-delta gating: when no fitted landmark moved more than this since the
+  // last fit, fitting and skinning are skipped and the previous mesh is kept.
+  // Otherwise only vertices influenced by joints whose rotation changed are
+  // re-skinned. 0 refits every frame.
+  float poseDeltaThreshold = 0.002f; // Normalized frame units
+  std::string smplModelPath; // Binary model from tools/convert_smpl.py (empty = placeholder)
+
+  // Keyframe scheduling: the pose estimator runs at least every
+  // keyframeInterval frames, or earlier when the downsampled frame difference
+  // exceeds motionThreshold. Landmarks in between are extrapolated with a
+  // constant-velocity model. An interval of 1 runs inference on every frame.
+  int keyframeInterval = 2;
+  float motionThreshold = 0.04f; // Mean absolute luma difference (0-1)
+
+  // Overlap inference on a keyframe with fitting/skinning of the previous
+  // results; detections arrive one keyframe later and are extrapolated to
+  // the current frame.
+  bool pipelinedInference = true;
 };
 
+/**
+ * @brief SMPL model dimensions
+ */
+constexpr int SMPL_NUM_VERTICES = 6890;
+constexpr int SMPL_NUM_JOINTS = 24;
+constexpr int SMPL_NUM_BETAS = 10;
+constexpr int SMPL_NUM_POSE_FEATURES = (SMPL_NUM_JOINTS - 1) * 9;
+
 /**
  * @brief SMPL body model parameters
  */
@@ -32,15 +74,33 @@ struct SMPLParams {
   float scale = 1.0f;
 };
 
+/**
+ * @brief A person tracked across frames
+ */
+struct TrackedPerson {
+  int trackId = -1; // Stable while the person stays in view
+  BodyPose pose;
+  SMPLParams smplParams;
+  std::vector<Point3D> bodyMesh;
+  bool meshChanged = true; // False if bodyMesh was kept from the previous frame
+};
+
 /**
  * @brief Body tracking result
+ *
+ * pose, smplParams and bodyMesh describe the primary (oldest) track;
+ * people holds every tracked person when numPoses > 1.
  */
 struct BodyTrackingResult {
   BodyPose pose;
   SMPLParams smplParams;
   std::vector<Point3D> bodyMesh; // 3D mesh vertices if available
-  ImageData segmentationMask;    // Body segmentation if enabled
+  SegmentationMask segmentationMask; // Body segmentation at reduced resolution if enabled
+  RunLengthMask segmentationRuns;    // Run-length form if segmentationRunLength
   float processingTimeMs = 0.0f;
+  bool isKeyframe = true; // True if inference was started on this frame
+  bool bodyMeshChanged = true; // False if bodyMesh equals the previous frame's
+  std::vector<TrackedPerson> people; // Ordered by trackId
 };
 
 /**
@@ -70,6 +130,17 @@ public:
    */
   Result<BodyTrackingResult> processFrame(const CameraFrame &frame);
 
+  /**
+   * @brief Process a frame into a caller-owned result
+   *
+   * Reuses the result's buffers (e.g. bodyMesh) across frames.
+   *
+   * @param frame Input camera frame
+   * @param result Body tracking result to overwrite
+   * @return Result indicating success or failure
+   */
+  Result<void> processFrame(const CameraFrame &frame, BodyTrackingResult &result);
+
   /**
    * @brief Convert 2D landmarks to 3D pose using depth estimation
    * @param landmarks2D 2D landmark positions
@@ -81,11 +152,31 @@ public:
 
   /**
    * @brief Fit SMPL model to detected pose
+   *
+   * Landmarks (frame-normalized, y-down) are first rotated into the y-up
+   * model frame; the fitted body lives in that frame, in frame-normalized
+   * units. Translation and scale are initialized from the hips and
+   * shoulders, then translation, shape and joint rotations are refined
+   * with Levenberg-Marquardt using analytic kinematic-chain Jacobians.
+   * Refinement needs a model with a joint regressor (smplModelPath).
+   *
    * @param pose Detected body pose
    * @return SMPL parameters
    */
   SMPLParams fitSMPL(const BodyPose &pose);
 
+  /**
+   * @brief Refine SMPL parameters starting from a previous estimate
+   *
+   * Starting from the previous frame's parameters this usually converges in
+   * 1-3 iterations. Stops after fitMaxIterations or fitTimeBudgetMs.
+   *
+   * @param pose Detected body pose
+   * @param initial Warm-start parameters (e.g. the previous frame's fit)
+   * @return SMPL parameters
+   */
+  SMPLParams fitSMPL(const BodyPose &pose, const SMPLParams &initial);
+
   /**
    * @brief Get body mesh from SMPL parameters
    * @param params SMPL parameters
@@ -93,6 +184,36 @@ public:
    */
   std::vector<Point3D> getSMPLMesh(const SMPLParams &params);
 
+  /**
+   * @brief Get body mesh from SMPL parameters into a caller-owned buffer
+   *
+   * Runs the SMPL forward pass: shape blendshapes, joint regression, pose
+   * blendshapes and linear blend skinning over 24 joints. The shaped rest
+   * mesh is reused while betas are unchanged, and nothing is allocated once
+   * the buffer holds SMPL_NUM_VERTICES entries. Safe to call from any thread:
+   * calls share one internal workspace and are serialized.
+   *
+   * @param params SMPL parameters
+   * @param vertices Output vertices (resized to SMPL_NUM_VERTICES if needed)
+   */
+  void getSMPLMesh(const SMPLParams &params, std::vector<Point3D> &vertices);
+
+  /**
+   * @brief Replace the pose-inference backend
+   *
+   * Defaults to ReferencePoseEstimator when initialize() is called without
+   * one. Set before initialize() or between frames.
+   */
+  void setPoseEstimator(std::shared_ptr<IPoseEstimator> estimator);
+
+  /**
+   * @brief Publish the primary person's pose to a latch after every frame
+   *
+   * Lets a renderer on another thread pick up the newest pose right before
+   * rasterizing (see ARRenderer::setPoseLatch). Pass nullptr to stop.
+   */
+  void setPoseLatch(std::shared_ptr<PoseLatch> latch);
+
   /**
    * @brief Check if tracker is initialized
    */
@@ -0,0 +1,82 @@
+/**
+ * @file conversion_client.h
+ * @brief Asynchronous client for server-side (hybrid) garment conversion
+ */
+
+#pragma once
+
+#include "garment_converter.h"
+#include "types.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace arfit {
+
+/**
+ * @brief Conversion client configuration
+ */
+struct ConversionClientConfig {
+  std::string endpoint;        // Server base URL, http://host[:port][/path]
+  int maxConnections = 4;      // Worker threads, each keeping one connection alive
+  int maxQueuedRequests = 64;  // Requests waiting for a worker beyond this fail immediately
+  int timeoutMs = 30000;       // Connect, send and receive timeout
+};
+
+/**
+ * @brief Client statistics
+ */
+struct ConversionClientStats {
+  uint64_t requests = 0;          // convert() calls
+  uint64_t coalesced = 0;         // Calls attached to an identical request already pending
+  uint64_t serverRequests = 0;    // HTTP requests actually sent
+  uint64_t connectionsOpened = 0; // TCP connections established
+};
+
+/**
+ * @brief Non-blocking client for the garment conversion server
+ *
+ * convert() only enqueues and returns. A fixed pool of workers sends
+ * `GET <path>/convert?url=<image URL>` over persistent HTTP/1.1 keep-alive
+ * connections and expects the garment in the ARFit garment binary format
+ * (the same layout the garment cache writes), with Content-Length or
+ * chunked framing. The response is decoded while it streams in, so it is
+ * never buffered whole.
+ *
+ * Concurrent requests for the same image URL are coalesced: one server
+ * request is made and every caller receives the same Garment instance.
+ */
+class ConversionClient {
+public:
+  explicit ConversionClient(const ConversionClientConfig &config);
+
+  /**
+   * @brief Cancels queued requests and aborts in-flight ones
+   *
+   * Their callbacks receive NETWORK_ERROR before the destructor returns.
+   */
+  ~ConversionClient();
+
+  // Prevent copying
+  ConversionClient(const ConversionClient &) = delete;
+  ConversionClient &operator=(const ConversionClient &) = delete;
+
+  /**
+   * @brief Request a conversion without blocking
+   *
+   * If the queue is full or the endpoint is invalid, the callback is invoked
+   * immediately on the calling thread with NETWORK_ERROR.
+   *
+   * @param imageUrl URL of the garment image, passed to the server
+   * @param callback Result callback
+   */
+  void convert(const std::string &imageUrl, ConversionCallback callback);
+
+  ConversionClientStats getStats() const;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace arfit
@@ -0,0 +1,103 @@
+/**
+ * @file drape_cache.h
+ * @brief On-disk cache of pre-settled garment drapes keyed by body shape
+ */
+
+#pragma once
+
+#include "types.h"
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace arfit {
+
+class Garment;
+
+/**
+ * @brief Drape cache configuration
+ */
+struct DrapeCacheConfig {
+  std::string directory;          // Where settled drapes are stored
+  float betaQuantization = 0.5f;  // Bucket width in SMPL beta units
+  int numQuantizedBetas = 2;      // Leading betas used in the key (height/weight)
+};
+
+/**
+ * @brief Quantized SMPL shape bucket
+ */
+using ShapeBucket = std::array<int8_t, 10>;
+
+/**
+ * @brief Cache of garment particle states settled on canonical bodies
+ *
+ * Each entry holds the settled particle positions of one garment for one
+ * quantized body shape. Lookups return the entry whose bucket is closest
+ * to the requested shape. All methods are thread-safe so drapes can be
+ * baked in the background while the frame loop queries the cache.
+ */
+class DrapeCache {
+public:
+  DrapeCache();
+  ~DrapeCache();
+
+  // Prevent copying
+  DrapeCache(const DrapeCache &) = delete;
+  DrapeCache &operator=(const DrapeCache &) = delete;
+
+  /**
+   * @brief Open (and create if needed) the cache directory
+   * @param config Cache configuration
+   * @return Result indicating success or failure
+   */
+  Result<void> initialize(const DrapeCacheConfig &config);
+
+  /**
+   * @brief Stable key for a garment's simulation topology
+   *
+   * Hashes the garment type, faces and texture coordinates, which stay fixed
+   * while vertex positions are animated.
+   */
+  static uint64_t garmentKey(const Garment &garment);
+
+  /**
+   * @brief Quantize SMPL betas into a shape bucket
+   */
+  ShapeBucket quantize(const std::array<float, 10> &betas) const;
+
+  /**
+   * @brief Check whether a drape exists for the exact bucket
+   */
+  bool contains(uint64_t garmentKey, const ShapeBucket &bucket) const;
+
+  /**
+   * @brief Load the drape whose bucket is nearest to the given shape
+   * @param garmentKey Key from garmentKey()
+   * @param betas Current SMPL shape parameters
+   * @param positions Receives the settled particle positions
+   * @return true if a drape was found and loaded
+   */
+  bool findNearest(uint64_t garmentKey, const std::array<float, 10> &betas,
+                   std::vector<Point3D> &positions) const;
+
+  /**
+   * @brief Store a settled drape
+   * @param garmentKey Key from garmentKey()
+   * @param bucket Shape bucket the drape was settled for
+   * @param positions Settled particle positions
+   */
+  Result<void> store(uint64_t garmentKey, const ShapeBucket &bucket,
+                     const std::vector<Point3D> &positions);
+
+  /**
+   * @brief Check if cache is initialized
+   */
+  bool isInitialized() const;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace arfit
@@ -0,0 +1,80 @@
+/**
+ * @file garment_cache.h
+ * @brief On-disk cache of converted garments keyed by input content
+ */
+
+#pragma once
+
+#include "garment_converter.h"
+#include "types.h"
+#include <memory>
+#include <string>
+
+namespace arfit {
+
+/**
+ * @brief Garment cache configuration
+ */
+struct GarmentCacheConfig {
+  std::string directory; // Where converted garments are stored
+};
+
+/**
+ * @brief Content-addressed store of GarmentConverter output
+ *
+ * Entries are keyed by a hash of the source pixels, the requested garment
+ * type and the converter configuration, so any change to the input yields
+ * a different key. Each entry is a versioned binary file holding the mesh,
+ * texture, UVs, bone weights and spring constraints; loading maps the file
+ * and copies the sections straight into the garment. Entries written by a
+ * different format version are treated as misses. All methods are
+ * thread-safe.
+ */
+class GarmentCache {
+public:
+  GarmentCache();
+  ~GarmentCache();
+
+  // Prevent copying
+  GarmentCache(const GarmentCache &) = delete;
+  GarmentCache &operator=(const GarmentCache &) = delete;
+
+  /**
+   * @brief Open (and create if needed) the cache directory
+   * @param config Cache configuration
+   * @return Result indicating success or failure
+   */
+  Result<void> initialize(const GarmentCacheConfig &config);
+
+  /**
+   * @brief Content key of a conversion request
+   * @param image Source image
+   * @param type Requested garment type (as passed to convert())
+   * @param config Converter configuration
+   */
+  static uint64_t key(const ImageData &image, GarmentType type, const GarmentConverterConfig &config);
+
+  /**
+   * @brief Load a cached garment
+   * @return Garment, or nullptr if there is no valid entry for the key
+   */
+  std::shared_ptr<Garment> load(uint64_t key) const;
+
+  /**
+   * @brief Store a converted garment
+   * @param key Key from key()
+   * @param garment Conversion result
+   */
+  Result<void> store(uint64_t key, const Garment &garment);
+
+  /**
+   * @brief Check if cache is initialized
+   */
+  bool isInitialized() const;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace arfit
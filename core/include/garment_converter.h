@@ -8,7 +8,9 @@
 #include "mesh.h"
 #include "texture.h"
 #include "types.h"
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace arfit {
@@ -20,7 +22,7 @@ struct GarmentConverterConfig {
   bool useServerProcessing = true; // Use hybrid server-side processing
   std::string serverEndpoint = "";
   int maxTextureSize = 2048;
-  float meshResolution = 0.5f; // 0.0 - 1.0
+  float meshResolution = 0.5f; // 0.0 - 1.0, selects a level of MESH_TEMPLATE_LEVELS
   bool generateNormalMap = true;
   bool generateDisplacementMap = false;
 };
@@ -95,6 +97,33 @@ struct SegmentationResult {
   float confidence;
 };
 
+/**
+ * @brief Options for batch conversion
+ */
+struct GarmentBatchOptions {
+  GarmentType type = GarmentType::UNKNOWN; // Applied to every item (UNKNOWN = auto-detect)
+  int maxInFlight = 0;                     // Items held in memory at once (0 = one per pool thread)
+  float meshResolution = -1.0f;            // Template resolution 0.0 - 1.0 (< 0 = converter config)
+};
+
+/**
+ * @brief Receives one batch result as soon as it is ready
+ *
+ * Called from worker threads in completion order, never concurrently.
+ *
+ * @param index Position of the item in the input
+ * @param result Converted garment or the item's error
+ */
+using GarmentBatchCallback = std::function<void(size_t index, Result<std::shared_ptr<Garment>> result)>;
+
+/**
+ * @brief Receives the result of a server-side conversion
+ *
+ * Called from a conversion client worker thread. Callers whose requests were
+ * coalesced receive the same Garment instance.
+ */
+using ConversionCallback = std::function<void(const Result<std::shared_ptr<Garment>> &result)>;
+
 /**
  * @brief Garment converter for 2D to 3D conversion
  */
@@ -138,14 +167,55 @@ public:
   Result<std::shared_ptr<Garment>>
   convert(const ImageData &image, GarmentType type = GarmentType::UNKNOWN);
 
+  /**
+   * @brief Convert many images on the shared thread pool
+   *
+   * Each worker takes the next item and runs segmentation, fitting, rigging
+   * and texture preparation on it, so at most maxInFlight items are being
+   * processed at any time. Results are streamed to the callback and not
+   * retained. Returns once every item has been reported.
+   *
+   * @param images RGBA garment images
+   * @param onResult Result callback
+   * @param options Batch options
+   * @return GARMENT_CONVERSION_FAILED if any item failed
+   */
+  Result<void> convertBatch(const std::vector<ImageData> &images, const GarmentBatchCallback &onResult,
+                            const GarmentBatchOptions &options = GarmentBatchOptions{});
+
+  /**
+   * @brief Convert many image files on the shared thread pool
+   *
+   * Same as above, with decoding done by the workers as part of the pipeline
+   * so only in-flight images are held in memory.
+   *
+   * @param paths Image file paths
+   */
+  Result<void> convertBatch(const std::vector<std::string> &paths, const GarmentBatchCallback &onResult,
+                            const GarmentBatchOptions &options = GarmentBatchOptions{});
+
   /**
    * @brief Convert using server-side processing (hybrid approach)
+   *
+   * Blocks until the server responds. Requires useServerProcessing and a
+   * serverEndpoint at initialize().
+   *
    * @param imageUrl URL of the garment image
    * @return Converted garment
    */
   Result<std::shared_ptr<Garment>>
   convertFromServer(const std::string &imageUrl);
 
+  /**
+   * @brief Non-blocking variant of convertFromServer()
+   *
+   * Concurrent requests for the same URL share one server round trip.
+   *
+   * @param imageUrl URL of the garment image
+   * @param callback Result callback (see ConversionClient)
+   */
+  void convertFromServerAsync(const std::string &imageUrl, ConversionCallback callback);
+
   /**
    * @brief Generate UV mapping for garment mesh
    * @param garment Garment to generate UV for
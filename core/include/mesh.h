@@ -29,6 +29,24 @@ struct Face {
   uint32_t indices[3];
 };
 
+/**
+ * @brief Grid size of a garment template
+ */
+struct MeshTemplateLevel {
+  int rows;
+  int cols;
+};
+
+/**
+ * @brief Template resolution chain, coarsest first
+ *
+ * GarmentConverterConfig::meshResolution 0.0 - 1.0 maps evenly onto these
+ * levels; the default 0.5 selects the original 20x15 grid.
+ */
+constexpr int MESH_TEMPLATE_LEVEL_COUNT = 5;
+constexpr MeshTemplateLevel MESH_TEMPLATE_LEVELS[MESH_TEMPLATE_LEVEL_COUNT] = {
+    {10, 8}, {14, 10}, {20, 15}, {28, 21}, {40, 30}};
+
 /**
  * @brief 3D Mesh class
  */
@@ -37,6 +55,10 @@ public:
   Mesh();
   ~Mesh();
 
+  // Copies geometry only; GPU buffers are not shared
+  Mesh(const Mesh &other);
+  Mesh &operator=(const Mesh &other);
+
   // Vertex data
   void setVertices(std::vector<Vertex> vertices);
   const std::vector<Vertex> &getVertices() const;
@@ -57,13 +79,40 @@ public:
 
   /**
    * @brief Create a basic T-shirt template mesh
+   * @param rows Grid rows from collar to hem
+   * @param cols Grid columns across the body
+   */
+  static std::shared_ptr<Mesh> createTShirtTemplate(int rows = 20, int cols = 15);
+
+  /**
+   * @brief Create a pants template (hip section splitting into two legs)
+   * @param rows Grid rows from waist to ankle
+   * @param cols Grid columns across both legs (rounded up to even)
+   */
+  static std::shared_ptr<Mesh> createPantsTemplate(int rows = 20, int cols = 16);
+
+  /**
+   * @brief Create a dress template (fitted bodice, flared skirt)
+   * @param rows Grid rows from shoulder to hem
+   * @param cols Grid columns across the body
+   */
+  static std::shared_ptr<Mesh> createDressTemplate(int rows = 20, int cols = 15);
+
+  /**
+   * @brief Index into MESH_TEMPLATE_LEVELS for a mesh resolution (0.0 - 1.0)
+   */
+  static int templateLevel(float resolution);
+
+  /**
+   * @brief Create the template for a garment type at a given grid size
    */
-  static std::shared_ptr<Mesh> createTShirtTemplate();
+  static std::shared_ptr<Mesh> createTemplate(GarmentType type, const MeshTemplateLevel &level);
 
   /**
    * @brief Create mesh from garment type template
+   * @param resolution Mesh resolution (0.0 - 1.0)
    */
-  static std::shared_ptr<Mesh> createFromType(GarmentType type);
+  static std::shared_ptr<Mesh> createFromType(GarmentType type, float resolution = 0.5f);
 
   // Bounding box
   struct BoundingBox {
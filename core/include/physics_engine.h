@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include "drape_cache.h"
 #include "garment_converter.h"
 #include "types.h"
 #include <memory>
@@ -12,6 +13,16 @@
 
 namespace arfit {
 
+/**
+ * @brief Cloth constraint solver
+ */
+enum class ClothSolver {
+  PBD,                // Gauss-Seidel Position Based Dynamics
+  PROJECTIVE_DYNAMICS // Local/global solve with a prefactored system matrix. The matrix is
+                      // SPD for non-negative weights; PBD is a defensive fallback for
+                      // configurations that break that (negative projectiveWeight or stiffness)
+};
+
 /**
  * @brief Physics simulation configuration
  */
@@ -19,6 +30,7 @@ struct PhysicsConfig {
   float gravity = -9.81f;
   float timeStep = 1.0f / 60.0f;
   int solverIterations = 10;
+  ClothSolver solver = ClothSolver::PBD;
   float damping = 0.99f;
   float friction = 0.5f;
 
@@ -26,10 +38,20 @@ struct PhysicsConfig {
   float stretchStiffness = 0.9f;
   float bendStiffness = 0.5f;
   float shearStiffness = 0.7f;
+  float projectiveWeight = 5.0e4f; // Stiffness -> constraint weight for PROJECTIVE_DYNAMICS
+  float maxStretchRatio = 1.1f;    // Edges are clamped to restLength * ratio (0 disables)
 
   // Collision
   float collisionMargin = 0.01f;
   bool enableSelfCollision = true;
+  bool enableContinuousCollision = true; // Swept particle vs moving body spheres
+
+  // Vertices closer than this (e.g. duplicated along UV seams) share one particle.
+  // 0 disables welding.
+  float weldTolerance = 1.0e-5f;
+
+  // Layered garments: inner layers inflated by this thickness collide with outer ones
+  float layerThickness = 0.006f;
 };
 
 /**
@@ -72,8 +94,10 @@ public:
   /**
    * @brief Add a garment to the simulation
    * @param garment Garment to simulate
+   * @param layer Layer index (0 = innermost). Negative places the garment
+   *              on top of all garments already in the simulation.
    */
-  Result<void> addGarment(std::shared_ptr<Garment> garment);
+  Result<void> addGarment(std::shared_ptr<Garment> garment, int layer = -1);
 
   /**
    * @brief Remove a garment from simulation
@@ -96,11 +120,46 @@ public:
 
   /**
    * @brief Get current particle positions for a garment
+   *
+   * Welded particles are scattered back, so the result has one entry per
+   * render vertex of the garment mesh.
+   *
    * @param garment Garment to query
-   * @return Current particle positions
+   * @return Current positions per mesh vertex
    */
   std::vector<Point3D> getParticlePositions(std::shared_ptr<Garment> garment);
 
+  /**
+   * @brief Attach a drape cache used to warm-start newly added garments
+   * @param cache Drape cache (nullptr disables warm starts)
+   */
+  void setDrapeCache(std::shared_ptr<DrapeCache> cache);
+
+  /**
+   * @brief Set the current body shape used for drape cache lookups
+   * @param betas SMPL shape parameters
+   */
+  void setBodyShape(const std::array<float, 10> &betas);
+
+  /**
+   * @brief Settle a garment on a canonical body and store it in the drape cache
+   *
+   * Simulates on a private particle state with the given configuration, so
+   * it can run on a background thread while the engine keeps stepping the
+   * live garments or is re-initialized.
+   *
+   * @param garment Garment to settle (its current vertices are the start pose)
+   * @param canonicalBody Collision body in the canonical pose
+   * @param betas Body shape the drape is settled for
+   * @param config Simulation configuration snapshot to settle with
+   * @param settleSteps Number of fixed time steps to simulate
+   */
+  Result<void> bakeDrape(std::shared_ptr<Garment> garment,
+                         const CollisionBody &canonicalBody,
+                         const std::array<float, 10> &betas,
+                         const PhysicsConfig &config,
+                         int settleSteps = 120);
+
   /**
    * @brief Apply external force to simulation
    * @param force Force vector to apply
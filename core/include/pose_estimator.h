@@ -0,0 +1,160 @@
+/**
+ * @file pose_estimator.h
+ * @brief Pluggable asynchronous pose-inference backends
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace arfit {
+
+/**
+ * @brief Element type of the network input tensor
+ */
+enum class PoseTensorFormat {
+  FLOAT32, // RGB in [0, 1]
+  UINT8    // RGB in [0, 255]
+};
+
+/**
+ * @brief Placement of a letterboxed frame crop inside the tensor
+ *
+ * source pixel = (tensor pixel - pad) / scale + cropOrigin
+ */
+struct LetterboxTransform {
+  int tensorWidth = 0;
+  int tensorHeight = 0;
+  int sourceWidth = 0;
+  int sourceHeight = 0;
+  Point2D cropOrigin; // Source pixels
+  float scale = 1.0f; // Tensor pixels per source pixel
+  Point2D pad;        // Padding in tensor pixels
+
+  /**
+   * @brief Map tensor-normalized [0, 1] to frame-normalized [-1, 1] coordinates
+   */
+  Point3D tensorToFrame(const Point3D &p) const {
+    float sx = (p.x * tensorWidth - pad.x) / scale + cropOrigin.x;
+    float sy = (p.y * tensorHeight - pad.y) / scale + cropOrigin.y;
+    return {sx / sourceWidth * 2.0f - 1.0f, sy / sourceHeight * 2.0f - 1.0f, p.z};
+  }
+
+  /**
+   * @brief Map frame-normalized [-1, 1] to tensor-normalized [0, 1] coordinates
+   */
+  Point3D frameToTensor(const Point3D &p) const {
+    float sx = (p.x + 1.0f) * 0.5f * sourceWidth;
+    float sy = (p.y + 1.0f) * 0.5f * sourceHeight;
+    return {((sx - cropOrigin.x) * scale + pad.x) / tensorWidth,
+            ((sy - cropOrigin.y) * scale + pad.y) / tensorHeight, p.z};
+  }
+};
+
+/**
+ * @brief Network input tensor (NHWC, RGB)
+ */
+struct PoseInputTensor {
+  PoseTensorFormat format = PoseTensorFormat::FLOAT32;
+  std::vector<float> data;    // height x width x 3 (FLOAT32)
+  std::vector<uint8_t> bytes; // height x width x 3 (UINT8)
+  int width = 0;
+  int height = 0;
+  float timestamp = 0.0f;       // Timestamp of the source frame
+  LetterboxTransform transform; // Where the frame crop sits in the tensor
+};
+
+/**
+ * @brief Pose estimator configuration
+ */
+struct PoseEstimatorConfig {
+  int inputWidth = 256;
+  int inputHeight = 256;
+  PoseTensorFormat inputFormat = PoseTensorFormat::FLOAT32;
+  int maxPoses = 1;
+};
+
+/**
+ * @brief Asynchronous pose-inference backend
+ *
+ * Input is double-buffered: the caller fills the tensor returned by
+ * acquireInput() while the backend runs inference on the previously
+ * submitted one, then hands it over with submit(). Results are fetched per
+ * ticket with poll() (non-blocking) or wait(); the results of the two most
+ * recent submissions are retained.
+ */
+class IPoseEstimator {
+public:
+  virtual ~IPoseEstimator() = default;
+
+  virtual int inputWidth() const = 0;
+  virtual int inputHeight() const = 0;
+
+  /**
+   * @brief Input buffer for the next submission
+   *
+   * Blocks while the backend is still reading this buffer from the
+   * submission before last.
+   */
+  virtual PoseInputTensor &acquireInput() = 0;
+
+  /**
+   * @brief Start inference on the buffer returned by acquireInput()
+   * @return Ticket identifying this submission
+   */
+  virtual uint64_t submit() = 0;
+
+  /**
+   * @brief Fetch results if the submission has finished
+   *
+   * Landmark x/y are tensor-normalized [0, 1]; map them back with the
+   * submitted tensor's LetterboxTransform::tensorToFrame().
+   *
+   * @return true if poses were written
+   */
+  virtual bool poll(uint64_t ticket, std::vector<BodyPose> &poses) = 0;
+
+  /**
+   * @brief Block until the submission finishes and fetch its results
+   * @return false if the ticket is unknown or no longer retained
+   */
+  virtual bool wait(uint64_t ticket, std::vector<BodyPose> &poses) = 0;
+};
+
+/**
+ * @brief Deterministic CPU reference estimator
+ *
+ * Produces a fixed frame-space skeleton per person that sways with the
+ * tensor timestamp, projected into the tensor's crop, so identical inputs
+ * always give identical poses. Used as the default backend and in tests.
+ */
+class ReferencePoseEstimator : public IPoseEstimator {
+public:
+  explicit ReferencePoseEstimator(const PoseEstimatorConfig &config = PoseEstimatorConfig{});
+  ~ReferencePoseEstimator() override;
+
+  // Prevent copying
+  ReferencePoseEstimator(const ReferencePoseEstimator &) = delete;
+  ReferencePoseEstimator &operator=(const ReferencePoseEstimator &) = delete;
+
+  int inputWidth() const override;
+  int inputHeight() const override;
+  PoseInputTensor &acquireInput() override;
+  uint64_t submit() override;
+  bool poll(uint64_t ticket, std::vector<BodyPose> &poses) override;
+  bool wait(uint64_t ticket, std::vector<BodyPose> &poses) override;
+
+  /**
+   * @brief Run inference synchronously on one tensor
+   */
+  static void infer(const PoseInputTensor &input, int maxPoses, std::vector<BodyPose> &poses);
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace arfit
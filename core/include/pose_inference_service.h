@@ -0,0 +1,102 @@
+/**
+ * @file pose_inference_service.h
+ * @brief Process-wide pose inference that micro-batches requests across sessions
+ */
+
+#pragma once
+
+#include "pose_estimator.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace arfit {
+
+/**
+ * @brief Pose network that evaluates several input tensors in one call
+ */
+class IBatchPoseModel {
+public:
+  virtual ~IBatchPoseModel() = default;
+
+  /**
+   * @brief Run inference on a batch
+   * @param inputs Tensors of identical size and format
+   * @param maxPoses Maximum people per tensor
+   * @param outputs One pose list per input (tensor-normalized landmarks)
+   */
+  virtual void inferBatch(const std::vector<const PoseInputTensor *> &inputs, int maxPoses,
+                          std::vector<std::vector<BodyPose>> &outputs) = 0;
+};
+
+/**
+ * @brief Deterministic stub model
+ *
+ * Produces exactly what ReferencePoseEstimator::infer() gives for each
+ * tensor, so batched and unbatched runs can be compared in tests.
+ */
+class ReferenceBatchPoseModel : public IBatchPoseModel {
+public:
+  void inferBatch(const std::vector<const PoseInputTensor *> &inputs, int maxPoses,
+                  std::vector<std::vector<BodyPose>> &outputs) override;
+};
+
+/**
+ * @brief Batching configuration
+ */
+struct PoseInferenceServiceConfig {
+  PoseEstimatorConfig estimator; // Input size/format and maxPoses shared by all sessions
+  int maxBatchSize = 8;
+  float maxBatchDelayMs = 4.0f; // Longest a request waits for the batch to fill
+};
+
+/**
+ * @brief Batching statistics
+ */
+struct PoseInferenceStats {
+  uint64_t requests = 0;
+  uint64_t batches = 0;
+  float meanBatchSize = 0.0f;
+};
+
+/**
+ * @brief Shared inference service for server deployments
+ *
+ * Each session gets its own IPoseEstimator from createSession() and plugs it
+ * into its BodyTracker with setPoseEstimator(). Submitted tensors are queued;
+ * a worker thread forms a batch when maxBatchSize requests are waiting or the
+ * oldest has waited maxBatchDelayMs, runs one batched inference and hands
+ * each session its own results.
+ */
+class PoseInferenceService {
+public:
+  /**
+   * @param config Batching configuration
+   * @param model Batched model (nullptr = ReferenceBatchPoseModel)
+   */
+  explicit PoseInferenceService(const PoseInferenceServiceConfig &config = PoseInferenceServiceConfig{},
+                                std::shared_ptr<IBatchPoseModel> model = nullptr);
+
+  /**
+   * @brief Stops the worker; outstanding requests complete with no poses
+   */
+  ~PoseInferenceService();
+
+  // Prevent copying
+  PoseInferenceService(const PoseInferenceService &) = delete;
+  PoseInferenceService &operator=(const PoseInferenceService &) = delete;
+
+  /**
+   * @brief Create a per-session estimator backed by this service
+   */
+  std::shared_ptr<IPoseEstimator> createSession();
+
+  PoseInferenceStats getStats() const;
+
+private:
+  class Impl;
+  class Session;
+  std::shared_ptr<Impl> pImpl; // Shared with the sessions
+};
+
+} // namespace arfit
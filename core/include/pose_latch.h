@@ -0,0 +1,67 @@
+/**
+ * @file pose_latch.h
+ * @brief Lock-free single-slot hand-off of the most recent body pose
+ */
+
+#pragma once
+
+#include "types.h"
+#include <atomic>
+#include <cstdint>
+
+namespace arfit {
+
+/**
+ * @brief A pose published to a PoseLatch
+ */
+struct LatchedPose {
+  BodyPose pose;
+  float timestamp = 0.0f; // Capture time in seconds
+  uint64_t sequence = 0;  // Increments with every publish, 0 = nothing published yet
+};
+
+/**
+ * @brief Latest-value slot between one publisher and one reader thread
+ *
+ * Triple-buffered: publish() and read() never block or allocate, the reader
+ * always gets the newest complete pose, and intermediate poses the reader
+ * did not pick up are simply overwritten. The tracker publishes every pose
+ * it produces; the renderer reads it just before rasterizing.
+ */
+class PoseLatch {
+public:
+  /**
+   * @brief Publish a pose (publisher thread only)
+   */
+  void publish(const BodyPose &pose, float timestamp) {
+    LatchedPose &slot = buffers[back];
+    slot.pose = pose;
+    slot.timestamp = timestamp;
+    slot.sequence = ++published;
+    // Swap the written buffer into the middle and mark it fresh
+    back = state.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+
+  /**
+   * @brief Read the newest pose (reader thread only)
+   * @return Newest published pose (sequence 0 if none yet)
+   */
+  const LatchedPose &read() {
+    if (state.load(std::memory_order_relaxed) & FRESH) {
+      front = state.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    return buffers[front];
+  }
+
+private:
+  static constexpr uint8_t INDEX_MASK = 0x3;
+  static constexpr uint8_t FRESH = 0x4;
+
+  LatchedPose buffers[3];
+  std::atomic<uint8_t> state{1}; // Middle buffer index | FRESH
+  uint8_t back = 0;              // Publisher only
+  uint8_t front = 2;             // Reader only
+  uint64_t published = 0;        // Publisher only
+};
+
+} // namespace arfit
@@ -0,0 +1,75 @@
+/**
+ * @file pose_predictor.h
+ * @brief Extrapolates tracked poses to the expected display time
+ */
+
+#pragma once
+
+#include "body_tracker.h"
+#include "types.h"
+#include <memory>
+
+namespace arfit {
+
+/**
+ * @brief Pose predictor configuration
+ */
+struct PosePredictorConfig {
+  float maxHorizonMs = 100.0f;     // Predictions further ahead are clamped to this
+  float velocityCutoff = 6.0f;     // Hz, low-pass on the velocity estimate
+  float accelerationCutoff = 3.0f; // Hz, low-pass on the acceleration estimate
+  float minVisibility = 0.5f;      // Landmarks below this are not extrapolated
+};
+
+/**
+ * @brief Predicts BodyPose and SMPLParams at a future timestamp
+ *
+ * Tracks low-pass filtered velocity and acceleration of every landmark and
+ * of the SMPL pose, translation and scale, then extrapolates with a
+ * constant-acceleration model. Extrapolation fades out for weakly visible
+ * landmarks, and the predicted confidence drops with the prediction horizon.
+ * Shape parameters are passed through unchanged.
+ */
+class PosePredictor {
+public:
+  explicit PosePredictor(const PosePredictorConfig &config = PosePredictorConfig{});
+  ~PosePredictor();
+
+  // Prevent copying
+  PosePredictor(const PosePredictor &) = delete;
+  PosePredictor &operator=(const PosePredictor &) = delete;
+
+  /**
+   * @brief Add a measurement
+   * @param timestamp Capture time in seconds
+   */
+  void update(const BodyPose &pose, const SMPLParams &params, float timestamp);
+
+  /**
+   * @brief Predict the pose at a later time
+   *
+   * Returns the latest measurement unchanged until two measurements have
+   * been added.
+   *
+   * @param timestamp Target time in seconds (e.g. expected display time)
+   * @param pose Predicted pose
+   * @param params Predicted SMPL parameters
+   */
+  void predict(float timestamp, BodyPose &pose, SMPLParams &params) const;
+
+  /**
+   * @brief Whether a measurement has been added since the last reset
+   */
+  bool hasMeasurement() const;
+
+  /**
+   * @brief Forget all measurements
+   */
+  void reset();
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace arfit
@@ -0,0 +1,117 @@
+/**
+ * @file segmentation_mask.h
+ * @brief Compact body segmentation masks (low resolution, 1- or 8-bit, RLE)
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <vector>
+
+namespace arfit {
+
+/**
+ * @brief Storage format of a segmentation mask
+ */
+enum class MaskFormat {
+  BIT1, // 1 bit per pixel, LSB first, rows padded to whole bytes
+  UINT8 // Soft coverage 0-255
+};
+
+/**
+ * @brief Body segmentation mask at reduced resolution
+ *
+ * Covers a source frame of sourceWidth x sourceHeight pixels with a
+ * width x height grid, so one mask pixel spans several frame pixels.
+ */
+struct SegmentationMask {
+  MaskFormat format = MaskFormat::UINT8;
+  int width = 0;
+  int height = 0;
+  int sourceWidth = 0;
+  int sourceHeight = 0;
+  int rowStride = 0; // Bytes per row
+  std::vector<uint8_t> data;
+
+  /**
+   * @brief Resize and clear (keeps capacity across frames)
+   */
+  void allocate(int w, int h, MaskFormat fmt, int srcW, int srcH);
+
+  bool empty() const { return width == 0 || height == 0; }
+
+  /**
+   * @brief Coverage of a mask pixel (0-255; BIT1 masks return 0 or 255)
+   */
+  uint8_t at(int x, int y) const {
+    const uint8_t *row = &data[(size_t)y * rowStride];
+    if (format == MaskFormat::UINT8) return row[x];
+    return (row[x >> 3] >> (x & 7)) & 1 ? 255 : 0;
+  }
+
+  /**
+   * @brief Set a mask pixel (BIT1 masks threshold at 128)
+   */
+  void set(int x, int y, uint8_t value) {
+    uint8_t *row = &data[(size_t)y * rowStride];
+    if (format == MaskFormat::UINT8) {
+      row[x] = value;
+    } else if (value >= 128) {
+      row[x >> 3] |= (uint8_t)(1u << (x & 7));
+    } else {
+      row[x >> 3] &= (uint8_t)~(1u << (x & 7));
+    }
+  }
+
+  /**
+   * @brief Whether a source-frame pixel is covered by the body
+   */
+  bool covers(int sourceX, int sourceY) const {
+    if (empty() || sourceX < 0 || sourceY < 0 || sourceX >= sourceWidth || sourceY >= sourceHeight) {
+      return false;
+    }
+    return at(sourceX * width / sourceWidth, sourceY * height / sourceHeight) >= 128;
+  }
+};
+
+/**
+ * @brief Run-length encoded binary mask
+ *
+ * Each row is a sequence of alternating background/foreground run lengths,
+ * starting with background (possibly zero); rowStart indexes into runs.
+ */
+struct RunLengthMask {
+  int width = 0;
+  int height = 0;
+  std::vector<uint16_t> runs;
+  std::vector<uint32_t> rowStart; // height + 1 entries
+};
+
+/**
+ * @brief Encode a mask as runs (UINT8 masks are thresholded at 128)
+ */
+void encodeRunLength(const SegmentationMask &mask, RunLengthMask &rle);
+
+/**
+ * @brief Decode runs into a mask of the given format
+ */
+void decodeRunLength(const RunLengthMask &rle, MaskFormat format, int sourceWidth,
+                     int sourceHeight, SegmentationMask &mask);
+
+/**
+ * @brief Upsample a mask to full frame resolution guided by the frame colors
+ *
+ * Joint-bilateral upsampling: each output pixel blends its 2x2 mask
+ * neighbours, weighting them by bilinear distance and by how close the
+ * frame color under each neighbour is to the output pixel's color, so mask
+ * edges snap to image edges. Pixels whose neighbours agree are filled
+ * without any color work.
+ *
+ * @param mask Low-resolution mask
+ * @param guide Camera frame the mask was computed from
+ * @param out Coverage 0-255, guide.width x guide.height
+ */
+void upsampleMask(const SegmentationMask &mask, const ImageData &guide, std::vector<uint8_t> &out);
+
+} // namespace arfit
@@ -0,0 +1,137 @@
+/**
+ * @file smpl_model.h
+ * @brief SMPL body model data and its memory-mapped binary format
+ *
+ * File layout (little-endian, version 1):
+ *
+ *   SMPLModelHeader                      64 bytes
+ *   SMPLModelSection[SMPL_SECTION_COUNT] offset/size of each array
+ *   sections                             each aligned to SMPL_MODEL_ALIGNMENT
+ *
+ * Vertex arrays are stored as SoA planes of paddedVertices floats (x plane,
+ * y plane, z plane) so they can be fed to SIMD kernels straight from the
+ * mapping. Produce files with tools/convert_smpl.py.
+ */
+
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace arfit {
+
+constexpr char SMPL_MODEL_MAGIC[8] = {'A', 'R', 'F', 'S', 'M', 'P', 'L', '\0'};
+constexpr uint32_t SMPL_MODEL_VERSION = 1;
+constexpr uint32_t SMPL_MODEL_ALIGNMENT = 64;
+
+/**
+ * @brief Section indices of the binary model file
+ */
+enum SMPLModelSectionId : uint32_t {
+  SMPL_SECTION_TEMPLATE = 0,      // float [3][paddedVertices]
+  SMPL_SECTION_SHAPE_DIRS,        // float [numBetas][3][paddedVertices]
+  SMPL_SECTION_POSE_DIRS,         // float [numPoseFeatures][3][paddedVertices]
+  SMPL_SECTION_SKIN_WEIGHTS,      // float [numJoints][paddedVertices]
+  SMPL_SECTION_PARENTS,           // int32 [numJoints]
+  SMPL_SECTION_REGRESSOR_ROWS,    // int32 [numJoints + 1] (CSR row starts)
+  SMPL_SECTION_REGRESSOR_VERTEX,  // int32 [regressorNonZeros]
+  SMPL_SECTION_REGRESSOR_WEIGHT,  // float [regressorNonZeros]
+  SMPL_SECTION_GROUP_JOINT_MASK,  // uint32 [paddedVertices / 4]
+  SMPL_SECTION_COUNT
+};
+
+/**
+ * @brief Binary model file header
+ */
+struct SMPLModelHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t numVertices;
+  uint32_t paddedVertices;
+  uint32_t numJoints;
+  uint32_t numBetas;
+  uint32_t numPoseFeatures;
+  uint32_t regressorNonZeros;
+  uint32_t sectionCount;
+  uint8_t reserved[24];
+};
+static_assert(sizeof(SMPLModelHeader) == 64, "SMPLModelHeader must be 64 bytes");
+
+/**
+ * @brief Location of one array inside the file
+ */
+struct SMPLModelSection {
+  uint64_t offset;
+  uint64_t size; // bytes
+};
+
+/**
+ * @brief Read-only view of SMPL model arrays
+ */
+struct SMPLModelData {
+  int numVertices = 0;
+  int paddedVertices = 0;
+  int numJoints = 0;
+  int numBetas = 0;
+  int numPoseFeatures = 0;
+
+  const float *templateVertices = nullptr;
+  const float *shapeDirs = nullptr;
+  const float *poseDirs = nullptr;
+  const float *skinWeights = nullptr;
+  const int32_t *parents = nullptr;
+  const int32_t *regressorRowStart = nullptr;
+  const int32_t *regressorVertex = nullptr;
+  const float *regressorWeight = nullptr;
+  const uint32_t *groupJointMask = nullptr; // Joints influencing each 4-vertex group
+};
+
+/**
+ * @brief SMPL model backed by a memory-mapped file or in-memory placeholder
+ */
+class SMPLModel {
+public:
+  SMPLModel();
+  ~SMPLModel();
+
+  // Prevent copying
+  SMPLModel(const SMPLModel &) = delete;
+  SMPLModel &operator=(const SMPLModel &) = delete;
+
+  /**
+   * @brief Map a binary model file; nothing is copied
+   *
+   * Besides the header and section table, only the small index arrays used
+   * without bounds checks later (parents, joint regressor rows and vertices)
+   * are read and validated.
+   *
+   * @param path Path to a file produced by tools/convert_smpl.py
+   * @return Loaded model, or MODEL_LOAD_FAILED for a truncated or corrupt file
+   */
+  static Result<std::shared_ptr<SMPLModel>> load(const std::string &path);
+
+  /**
+   * @brief Create an all-zero model rigidly attached to the root joint
+   *
+   * Used when no model file is configured.
+   */
+  static std::shared_ptr<SMPLModel> createPlaceholder();
+
+  /**
+   * @brief Model arrays
+   */
+  const SMPLModelData &data() const;
+
+  /**
+   * @brief Check if the model is backed by a file mapping
+   */
+  bool isMemoryMapped() const;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+} // namespace arfit
@@ -172,6 +172,16 @@ struct SessionConfig {
     // Server-side processing configuration
     std::string serverEndpoint = "";
     bool useHybridProcessing = true;
+
+    // Directory for pre-settled garment drapes (empty disables the cache)
+    std::string drapeCacheDirectory = "";
+
+    // Directory for converted garments keyed by image content (empty disables the cache)
+    std::string garmentCacheDirectory = "";
+
+    // Predict the body pose at display time so garments do not trail motion
+    bool enablePosePrediction = true;
+    float displayLatencyMs = 0.0f; // Capture-to-display latency (0 = measured pipeline latency + 1 frame)
 };
 
 /**
@@ -186,7 +196,8 @@ enum class ErrorCode {
     GARMENT_CONVERSION_FAILED,
     INVALID_IMAGE,
     SESSION_NOT_STARTED,
-    NETWORK_ERROR
+    NETWORK_ERROR,
+    IO_ERROR
 };
 
 /**
@@ -5,6 +5,7 @@
 
 #include "ar_renderer.h"
 #include <algorithm>
+#include <array>
 #include <cstring>
 #include <iostream>
 #include <vector>
@@ -12,10 +13,80 @@
 
 namespace arfit {
 
+namespace {
+
+using Matrix4 = std::array<float, 16>; // 列優先
+
+Matrix4 multiply(const Matrix4 &a, const Matrix4 &b) {
+  Matrix4 out{};
+  for (int c = 0; c < 4; ++c) {
+    for (int r = 0; r < 4; ++r) {
+      float sum = 0.0f;
+      for (int k = 0; k < 4; ++k) sum += a[k * 4 + r] * b[c * 4 + k];
+      out[c * 4 + r] = sum;
+    }
+  }
+  return out;
+}
+
+/**
+ * 余因子展開による逆行列（特異なら false）
+ */
+bool invert(const Matrix4 &m, Matrix4 &out) {
+  Matrix4 inv;
+  inv[0] = m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] +
+           m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+  inv[4] = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] -
+           m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+  inv[8] = m[4] * m[9] * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] +
+           m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+  inv[12] = -m[4] * m[9] * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] -
+            m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+  inv[1] = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] -
+           m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+  inv[5] = m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] +
+           m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+  inv[9] = -m[0] * m[9] * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] -
+           m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+  inv[13] = m[0] * m[9] * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] +
+            m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+  inv[2] = m[1] * m[6] * m[15] - m[1] * m[7] * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] +
+           m[13] * m[2] * m[7] - m[13] * m[3] * m[6];
+  inv[6] = -m[0] * m[6] * m[15] + m[0] * m[7] * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] -
+           m[12] * m[2] * m[7] + m[12] * m[3] * m[6];
+  inv[10] = m[0] * m[5] * m[15] - m[0] * m[7] * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] +
+            m[12] * m[1] * m[7] - m[12] * m[3] * m[5];
+  inv[14] = -m[0] * m[5] * m[14] + m[0] * m[6] * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] -
+            m[12] * m[1] * m[6] + m[12] * m[2] * m[5];
+  inv[3] = -m[1] * m[6] * m[11] + m[1] * m[7] * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] -
+           m[9] * m[2] * m[7] + m[9] * m[3] * m[6];
+  inv[7] = m[0] * m[6] * m[11] - m[0] * m[7] * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] +
+           m[8] * m[2] * m[7] - m[8] * m[3] * m[6];
+  inv[11] = -m[0] * m[5] * m[11] + m[0] * m[7] * m[9] + m[4] * m[1] * m[11] - m[4] * m[3] * m[9] -
+            m[8] * m[1] * m[7] + m[8] * m[3] * m[5];
+  inv[15] = m[0] * m[5] * m[10] - m[0] * m[6] * m[9] - m[4] * m[1] * m[10] + m[4] * m[2] * m[9] +
+            m[8] * m[1] * m[6] - m[8] * m[2] * m[5];
+
+  float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+  if (std::abs(det) < 1e-12f) return false;
+  for (int i = 0; i < 16; ++i) out[i] = inv[i] / det;
+  return true;
+}
+
+// 同次座標変換（wを返す）
+Point3D transformPoint(const Matrix4 &m, const Point3D &p, float &w) {
+  w = m[3] * p.x + m[7] * p.y + m[11] * p.z + m[15];
+  return {m[0] * p.x + m[4] * p.y + m[8] * p.z + m[12], m[1] * p.x + m[5] * p.y + m[9] * p.z + m[13],
+          m[2] * p.x + m[6] * p.y + m[10] * p.z + m[14]};
+}
+
+} // namespace
+
 /**
  * @brief 描画対象のオブジェクト
  */
 struct RenderObject {
+  std::shared_ptr<Garment> garment;
   std::shared_ptr<Mesh> mesh;
   std::shared_ptr<Texture> texture;
   Transform transform;
@@ -35,8 +106,31 @@ public:
   int width = 0;
   int height = 0;
 
+  // レイトラッチ（シミュレーション時の姿勢と描画直前の最新姿勢の差で補正）
+  std::shared_ptr<PoseLatch> poseLatch;
+  BodyPose measuredPose;            // 予測の起点となった実測姿勢
+  float captureTimestamp = 0.0f;
+  BodyPose simulationPose;          // 衝突判定に使った姿勢（予測時は表示時刻の姿勢）
+  float simulationTimestamp = 0.0f;
+  bool hasSimulationPose = false;
+  std::array<Point3D, 33> landmarkCorrection;
+  bool hasCorrection = false;
+  std::vector<Point3D> correctedPositions; // 作業領域
+
+  // カメラ行列（未設定の間は組み込みの透視投影を使う）
+  Matrix4 projection = Transform::identity().matrix;
+  Matrix4 view = Transform::identity().matrix;
+  Matrix4 viewProjection = Transform::identity().matrix;
+  Matrix4 inverseViewProjection = Transform::identity().matrix;
+  bool hasCameraMatrices = false;
+
   Impl() {}
 
+  void updateViewProjection() {
+    viewProjection = multiply(projection, view);
+    hasCameraMatrices = invert(viewProjection, inverseViewProjection);
+  }
+
   void resize(int w, int h) {
     width = w;
     height = h;
@@ -44,18 +138,42 @@ public:
     depthBuffer.resize(width * height);
   }
 
+  static constexpr float BUILTIN_FOV = 1.2f;
+  static constexpr float BUILTIN_CAMERA_DISTANCE = 2.5f;
+
+  /**
+   * ワールド座標から正規化デバイス座標へ（zはtoWorldで戻すための値、outZは深度テスト用）
+   */
+  Point3D toNdc(const Point3D &p, float &outZ) const {
+    if (hasCameraMatrices) {
+      float w;
+      Point3D clip = transformPoint(viewProjection, p, w);
+      outZ = std::max(w, 0.1f);
+      return {clip.x / outZ, clip.y / outZ, clip.z / outZ};
+    }
+    // z座標で除算して透視投影を実現
+    outZ = std::max(p.z + BUILTIN_CAMERA_DISTANCE, 0.1f);
+    return {(p.x * BUILTIN_FOV / outZ) * (height / (float)width), p.y * BUILTIN_FOV / outZ, outZ};
+  }
+
+  /**
+   * toNdc の逆変換
+   */
+  Point3D toWorld(const Point3D &ndc) const {
+    if (hasCameraMatrices) {
+      float w;
+      Point3D p = transformPoint(inverseViewProjection, ndc, w);
+      return p * (1.0f / w);
+    }
+    return {ndc.x * ndc.z / BUILTIN_FOV * (width / (float)height), ndc.y * ndc.z / BUILTIN_FOV,
+            ndc.z - BUILTIN_CAMERA_DISTANCE};
+  }
+
   Point2D project(const Point3D& p, float& outZ) {
-      // z座標で除算して透視投影を実現
-      outZ = p.z + 2.5f; 
-      if (outZ < 0.1f) outZ = 0.1f;
-      
-      float fov = 1.2f; 
-      float x = (p.x * fov / outZ) * (height / (float)width);
-      float y = (p.y * fov / outZ);
-      
+      Point3D ndc = toNdc(p, outZ);
       return {
-          (x + 1.0f) * 0.5f * width,
-          (1.0f - y) * 0.5f * height
+          (ndc.x + 1.0f) * 0.5f * width,
+          (1.0f - ndc.y) * 0.5f * height
       };
   }
 
@@ -79,25 +197,86 @@ public:
       return (v >= 0) && (w >= 0) && (u >= 0);
   }
 
+  /**
+   * 最新の姿勢を読み、シミュレーション時からのランドマークごとの移動量を求める
+   */
+  void latchPose() {
+    hasCorrection = false;
+    if (!config.enableLateLatch || !poseLatch || !hasSimulationPose) return;
+
+    // 最新の姿勢は撮影時刻で打刻されているので、予測の起点となった実測姿勢と比べる
+    const LatchedPose &latest = poseLatch->read();
+    if (latest.sequence == 0 || latest.timestamp <= captureTimestamp) return;
+
+    // 予測が仮定した動きで最新の姿勢を表示時刻まで外挿し、予測姿勢との差だけを補正する
+    float horizon = simulationTimestamp - captureTimestamp;
+    float remaining = horizon > 0.0f ? std::max(simulationTimestamp - latest.timestamp, 0.0f) / horizon : 0.0f;
+
+    // ランドマークはフレーム正規化座標（[-1, 1]、y下向き）なので、画面上の移動量として
+    // 正規化デバイス座標（y上向き）へ直す。奥行きは単眼推定の相対値のため使わない
+    float maxCorrection = config.maxLateLatchCorrection;
+    for (size_t i = 0; i < landmarkCorrection.size(); ++i) {
+      Point3D predictedMotion = simulationPose.landmarks[i] - measuredPose.landmarks[i];
+      Point3D d = latest.pose.landmarks[i] + predictedMotion * remaining - simulationPose.landmarks[i];
+      float length = std::sqrt(d.x * d.x + d.y * d.y);
+      landmarkCorrection[i] = length <= maxCorrection ? Point3D{d.x, -d.y, 0.0f} : Point3D{};
+      hasCorrection = hasCorrection || length > 0.0f;
+    }
+  }
+
+  /**
+   * リギングされた頂点をボーン重みで画面上に平行移動し、同じ深度でワールド座標へ戻す
+   * （物理は再計算しない）
+   */
+  const std::vector<Point3D> *correctGarment(const RenderObject &obj) {
+    if (!hasCorrection || !obj.garment) return nullptr;
+    const auto &weights = obj.garment->getBoneWeights();
+    const auto &vertices = obj.mesh->getVertices();
+    if (weights.size() != vertices.size()) return nullptr;
+
+    correctedPositions.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+      Point3D shift;
+      for (const auto &w : weights[i]) {
+        if (w.boneIndex >= 0 && w.boneIndex < (int)landmarkCorrection.size()) {
+          shift = shift + landmarkCorrection[w.boneIndex] * w.weight;
+        }
+      }
+      if (shift.x == 0.0f && shift.y == 0.0f) {
+        correctedPositions[i] = vertices[i].position;
+        continue;
+      }
+      float depth;
+      Point3D ndc = toNdc(vertices[i].position, depth);
+      correctedPositions[i] = toWorld({ndc.x + shift.x, ndc.y + shift.y, ndc.z});
+    }
+    return &correctedPositions;
+  }
+
   void drawGarments() {
     // 深度バッファを初期化 (遠くの値をセット)
     std::fill(depthBuffer.begin(), depthBuffer.end(), 1000.0f);
+    latchPose();
 
     for (const auto &obj : garments) {
       if (!obj.visible || !obj.mesh) continue;
 
       const auto& vertices = obj.mesh->getVertices();
       const auto& faces = obj.mesh->getFaces();
-      
+      const std::vector<Point3D> *corrected = correctGarment(obj);
+      auto position = [&](int index) -> const Point3D & {
+        return corrected ? (*corrected)[index] : vertices[index].position;
+      };
+
       for (const auto& face : faces) {
           const auto& v0 = vertices[face.indices[0]];
           const auto& v1 = vertices[face.indices[1]];
           const auto& v2 = vertices[face.indices[2]];
 
           float z0, z1, z2;
-          Point2D p0 = project(v0.position, z0);
-          Point2D p1 = project(v1.position, z1);
-          Point2D p2 = project(v2.position, z2);
+          Point2D p0 = project(position(face.indices[0]), z0);
+          Point2D p1 = project(position(face.indices[1]), z1);
+          Point2D p2 = project(position(face.indices[2]), z2);
           
           // 面の法線の平均を使ったランバート反射ライティング
           Point3D avgNormal = {
@@ -183,6 +362,7 @@ void ARRenderer::setCameraFrame(const CameraFrame &frame) {
 
 void ARRenderer::addGarment(std::shared_ptr<Garment> garment, const std::vector<Point3D> &positions) {
   RenderObject obj;
+  obj.garment = garment;
   obj.mesh = garment->getMesh();
   obj.texture = garment->getTexture();
   obj.visible = true;
@@ -208,6 +388,17 @@ void ARRenderer::removeGarment(std::shared_ptr<Garment> garment) {
   pImpl->garments.erase(it, pImpl->garments.end());
 }
 
+void ARRenderer::setSimulationPose(const BodyPose &measuredPose, float captureTime,
+                                   const BodyPose &simulatedPose, float displayTime) {
+  pImpl->measuredPose = measuredPose;
+  pImpl->captureTimestamp = captureTime;
+  pImpl->simulationPose = simulatedPose;
+  pImpl->simulationTimestamp = displayTime;
+  pImpl->hasSimulationPose = true;
+}
+
+void ARRenderer::setPoseLatch(std::shared_ptr<PoseLatch> latch) { pImpl->poseLatch = std::move(latch); }
+
 Result<ImageData> ARRenderer::render() {
   if (!pImpl->initialized) return {.error = ErrorCode::INITIALIZATION_FAILED};
   pImpl->drawBackground();
@@ -220,8 +411,15 @@ Result<ImageData> ARRenderer::render() {
   return {.value = result, .error = ErrorCode::SUCCESS};
 }
 
-void ARRenderer::setProjectionMatrix(const Transform &projection) {}
-void ARRenderer::setViewMatrix(const Transform &view) {}
+void ARRenderer::setProjectionMatrix(const Transform &projection) {
+  pImpl->projection = projection.matrix;
+  pImpl->updateViewProjection();
+}
+
+void ARRenderer::setViewMatrix(const Transform &view) {
+  pImpl->view = view.matrix;
+  pImpl->updateViewProjection();
+}
 bool ARRenderer::isInitialized() const { return pImpl->initialized; }
 std::string ARRenderer::getBackendType() const { return "Software"; }
 
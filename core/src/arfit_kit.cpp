@@ -4,8 +4,11 @@
  */
 
 #include "arfit_kit.h"
+#include "garment_cache.h"
 #include <chrono>
+#include <future>
 #include <mutex>
+#include <set>
 #include <unordered_map>
 #include <algorithm>
 
@@ -24,13 +27,41 @@ public:
   std::unique_ptr<GarmentConverter> garmentConverter;
   std::unique_ptr<PhysicsEngine> physicsEngine;
   std::unique_ptr<ARRenderer> renderer;
+  PhysicsConfig physicsConfig; // ドレープの事前計算ジョブへ渡すスナップショットの元
 
   // 読み込まれた衣服の管理 (ID -> 衣服オブジェクト)
   std::unordered_map<std::string, std::shared_ptr<Garment>> garmentRegistry;
+
+  // 変換済み衣服のキャッシュ（キーには変換設定も含める）
+  std::unique_ptr<GarmentCache> garmentCache;
+  GarmentConverterConfig converterConfig;
   
+  // 直近のトラッキング結果（メッシュバッファを毎フレーム再利用）
+  BodyTrackingResult trackingResult;
+
+  // 表示時刻への姿勢予測（衝突判定と描画は予測姿勢を使う）
+  PosePredictor posePredictor;
+  BodyPose predictedPose;
+  SMPLParams predictedParams;
+  std::vector<Point3D> predictedMesh;
+  int predictedTrackId = -1;
+
+  // 衝突判定ボディー（静止中は更新を省く）
+  CollisionBody collisionBody;
+  bool collisionBodySettled = false;
+
+  // トラッカーが公開する最新姿勢（レンダラーが描画直前に読む）
+  std::shared_ptr<PoseLatch> poseLatch = std::make_shared<PoseLatch>();
+
   // 現在試着中の衣服リスト
   std::vector<std::shared_ptr<Garment>> activeGarments;
 
+  // ドレープキャッシュと事前計算中のキー
+  std::shared_ptr<DrapeCache> drapeCache;
+  std::set<std::pair<uint64_t, ShapeBucket>> pendingDrapes;
+  std::mutex drapeMutex;
+  std::array<float, 10> bodyShape{};
+
   // コールバック
   FrameCallback frameCallback;
   PoseCallback poseCallback;
@@ -45,17 +76,85 @@ public:
 
   std::mutex mutex;
 
+  // ドレープの事前計算ジョブ。physicsEngine・drapeMutex・pendingDrapes に触れるため、
+  // メンバーの中で最初に破棄されて完了を待つよう最後に宣言する
+  std::vector<std::future<void>> drapeJobs;
+
+  // サーバー変換のコールバックが他のメンバーに触れるため、変換器を先に破棄して完了を待つ
+  ~Impl() { garmentConverter.reset(); }
+
   Impl() {
     bodyTracker = std::make_unique<BodyTracker>();
     garmentConverter = std::make_unique<GarmentConverter>();
     physicsEngine = std::make_unique<PhysicsEngine>();
     renderer = std::make_unique<ARRenderer>();
+    bodyTracker->setPoseLatch(poseLatch);
+    renderer->setPoseLatch(poseLatch);
+  }
+
+  /**
+   * 現在の体型に対応するドレープが無ければバックグラウンドで生成
+   */
+  void scheduleDrapeBake(std::shared_ptr<Garment> garment) {
+    if (!drapeCache) return;
+
+    // 完了したジョブを破棄
+    drapeJobs.erase(std::remove_if(drapeJobs.begin(), drapeJobs.end(),
+                                   [](std::future<void> &job) {
+                                     return job.wait_for(std::chrono::seconds(0)) ==
+                                            std::future_status::ready;
+                                   }),
+                    drapeJobs.end());
+
+    uint64_t key = DrapeCache::garmentKey(*garment);
+    ShapeBucket bucket = drapeCache->quantize(bodyShape);
+    {
+      std::lock_guard<std::mutex> lock(drapeMutex);
+      if (drapeCache->contains(key, bucket) || pendingDrapes.count({key, bucket})) return;
+      pendingDrapes.insert({key, bucket});
+    }
+
+    // 現在の体型で標準姿勢の体を生成
+    SMPLParams canonical;
+    canonical.pose.fill(0.0f);
+    canonical.shape = bodyShape;
+    canonical.translation = {0.0f, 0.0f, 0.0f};
+    CollisionBody body;
+    bodyTracker->getSMPLMesh(canonical, body.vertices);
+
+    // 描画で変形される前のメッシュをスナップショットとして渡す
+    auto mesh = std::make_shared<Mesh>();
+    mesh->setVertices(garment->getMesh()->getVertices());
+    mesh->setFaces(garment->getMesh()->getFaces());
+    auto snapshot = std::make_shared<Garment>();
+    snapshot->setType(garment->getType());
+    snapshot->setMesh(mesh);
+
+    // 設定もスナップショットで渡す（initialize() がエンジンの設定を書き換えても影響しない）
+    auto shape = bodyShape;
+    PhysicsConfig config = physicsConfig;
+    drapeJobs.push_back(std::async(std::launch::async, [this, snapshot, body, shape, config, key, bucket] {
+      physicsEngine->bakeDrape(snapshot, body, shape, config);
+      std::lock_guard<std::mutex> lock(drapeMutex);
+      pendingDrapes.erase({key, bucket});
+    }));
   }
 
   // 衣服IDを取得するヘルパー (単純なハッシュやUUIDなど)
   std::string generateId() {
     return std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
   }
+
+  /**
+   * 衣服を登録してIDを返す（サーバー変換の作業スレッドからも呼ばれる）
+   */
+  std::string registerGarment(std::shared_ptr<Garment> garment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string id = generateId();
+    while (garmentRegistry.count(id)) id = generateId();
+    garmentRegistry[id] = std::move(garment);
+    return id;
+  }
 };
 
 ARFitKit::ARFitKit() : pImpl(std::make_unique<Impl>()) {}
@@ -90,15 +189,38 @@ Result<void> ARFitKit::initialize(const SessionConfig &config) {
     return {.error = converterResult.error,
             .message = "衣服コンバーターの初期化に失敗しました"};
   }
+  pImpl->converterConfig = converterConfig;
+
+  // 衣服キャッシュの初期化（失敗しても毎回変換すればよい）
+  pImpl->garmentCache.reset();
+  if (!config.garmentCacheDirectory.empty()) {
+    auto cache = std::make_unique<GarmentCache>();
+    GarmentCacheConfig cacheConfig;
+    cacheConfig.directory = config.garmentCacheDirectory;
+    if (cache->initialize(cacheConfig)) {
+      pImpl->garmentCache = std::move(cache);
+    }
+  }
 
   // 物理エンジンの初期化
-  PhysicsConfig physicsConfig;
-  auto physicsResult = pImpl->physicsEngine->initialize(physicsConfig);
+  pImpl->physicsConfig = PhysicsConfig{};
+  auto physicsResult = pImpl->physicsEngine->initialize(pImpl->physicsConfig);
   if (!physicsResult) {
     return {.error = physicsResult.error,
             .message = "物理エンジンの初期化に失敗しました"};
   }
 
+  // ドレープキャッシュの初期化（失敗しても試着自体は可能）
+  if (!config.drapeCacheDirectory.empty()) {
+    auto cache = std::make_shared<DrapeCache>();
+    DrapeCacheConfig cacheConfig;
+    cacheConfig.directory = config.drapeCacheDirectory;
+    if (cache->initialize(cacheConfig)) {
+      pImpl->drapeCache = cache;
+      pImpl->physicsEngine->setDrapeCache(cache);
+    }
+  }
+
   // レンダラーの初期化
   RenderConfig renderConfig;
   renderConfig.enableShadows = config.enableShadows;
@@ -125,6 +247,8 @@ Result<void> ARFitKit::startSession() {
   pImpl->lastFrameTime = std::chrono::steady_clock::now();
   pImpl->frameCount = 0;
   pImpl->totalLatency = 0.0f;
+  pImpl->posePredictor.reset();
+  pImpl->collisionBodySettled = false;
 
   return {.error = ErrorCode::SUCCESS};
 }
@@ -153,24 +277,63 @@ Result<ImageData> ARFitKit::processFrame(const CameraFrame &frame) {
             .message = "セッションが開始されていません"};
   }
 
-  // 1. ボディトラッキング (ポーズ推定)
-  auto trackingResult = pImpl->bodyTracker->processFrame(frame);
-  if (trackingResult.hasError()) {
+  // 1. ボディトラッキング (ポーズ推定、結果のバッファはフレーム間で再利用)
+  auto &tracking = pImpl->trackingResult;
+  auto trackingStatus = pImpl->bodyTracker->processFrame(frame, tracking);
+  if (!trackingStatus) {
     if (pImpl->errorCallback) {
-      pImpl->errorCallback(trackingResult.error, trackingResult.message);
+      pImpl->errorCallback(trackingStatus.error, trackingStatus.message);
     }
   } else {
-    const auto &pose = trackingResult.value.pose;
+    const auto &pose = tracking.pose;
 
     // コールバック通知
     if (pImpl->poseCallback) {
       pImpl->poseCallback(pose);
     }
 
-    // 物理エンジン用の衝突判定ボディーを更新
-    CollisionBody collisionBody;
-    collisionBody.vertices = trackingResult.value.bodyMesh;
-    pImpl->physicsEngine->updateCollisionBody(collisionBody);
+    // パイプライン遅延分だけ先の表示時刻へ姿勢を予測し、そのメッシュを使う
+    const std::vector<Point3D> *bodyMesh = &tracking.bodyMesh;
+    const BodyPose *bodyPose = &pose;
+    float bodyPoseTime = frame.timestamp;
+    bool predicted = false;
+    if (pImpl->config.enablePosePrediction && !tracking.people.empty()) {
+      // 先頭の人物が入れ替わったら速度推定をやり直す
+      if (tracking.people.front().trackId != pImpl->predictedTrackId) {
+        pImpl->posePredictor.reset();
+        pImpl->predictedTrackId = tracking.people.front().trackId;
+      }
+      pImpl->posePredictor.update(pose, tracking.smplParams, frame.timestamp);
+      if (tracking.bodyMeshChanged) {
+        float latencyMs = pImpl->config.displayLatencyMs > 0.0f
+                              ? pImpl->config.displayLatencyMs
+                              : pImpl->averageLatency + 1000.0f / pImpl->config.targetFPS;
+        float displayTime = frame.timestamp + latencyMs * 0.001f;
+        pImpl->posePredictor.predict(displayTime, pImpl->predictedPose, pImpl->predictedParams);
+        pImpl->bodyTracker->getSMPLMesh(pImpl->predictedParams, pImpl->predictedMesh);
+        bodyMesh = &pImpl->predictedMesh;
+        bodyPose = &pImpl->predictedPose;
+        bodyPoseTime = displayTime;
+        predicted = true;
+      }
+    }
+
+    // 物理エンジン用の衝突判定ボディーを更新（静止中は前回のものをそのまま使う。
+    // 静止直後は予測で先行した位置を実測の位置に戻すため一度だけ更新する）
+    if (tracking.bodyMeshChanged || !pImpl->collisionBodySettled) {
+      CollisionBody &collisionBody = pImpl->collisionBody;
+      collisionBody.vertices.assign(bodyMesh->begin(), bodyMesh->end());
+      pImpl->physicsEngine->updateCollisionBody(collisionBody);
+      pImpl->collisionBodySettled = !predicted && !tracking.bodyMeshChanged;
+
+      // 衣服はこの姿勢（予測時は表示時刻の姿勢）に対してシミュレーションされる。
+      // 描画直前に撮影時刻がこの実測より新しい姿勢があれば、表示時刻へ外挿した差で補正する
+      pImpl->renderer->setSimulationPose(pose, frame.timestamp, *bodyPose, bodyPoseTime);
+    }
+
+    // ドレープキャッシュ検索用の体型
+    pImpl->bodyShape = tracking.smplParams.shape;
+    pImpl->physicsEngine->setBodyShape(pImpl->bodyShape);
   }
 
   // 2. 物理シミュレーション (布の動き)
@@ -215,11 +378,21 @@ Result<ImageData> ARFitKit::processFrame(const CameraFrame &frame) {
  */
 Result<std::string> ARFitKit::loadGarment(const ImageData &image,
                                                         GarmentType type) {
+  // 同じ画像・設定の変換結果がキャッシュにあれば変換を省く
+  uint64_t cacheKey = 0;
+  if (pImpl->garmentCache) {
+    cacheKey = GarmentCache::key(image, type, pImpl->converterConfig);
+    if (auto cached = pImpl->garmentCache->load(cacheKey)) {
+      return {.value = pImpl->registerGarment(cached), .error = ErrorCode::SUCCESS};
+    }
+  }
+
   auto result = pImpl->garmentConverter->convert(image, type);
   if (result.isSuccess()) {
-    const std::string id = pImpl->generateId();
-    pImpl->garmentRegistry[id] = result.value;
-    return {.value = id, .error = ErrorCode::SUCCESS};
+    if (pImpl->garmentCache) {
+      pImpl->garmentCache->store(cacheKey, *result.value); // 保存に失敗しても読み込み自体は成功
+    }
+    return {.value = pImpl->registerGarment(result.value), .error = ErrorCode::SUCCESS};
   }
   return {.error = result.error, .message = result.message};
 }
@@ -231,13 +404,26 @@ Result<std::string>
 ARFitKit::loadGarmentFromUrl(const std::string &url) {
   auto result = pImpl->garmentConverter->convertFromServer(url);
   if (result.isSuccess()) {
-    const std::string id = pImpl->generateId();
-    pImpl->garmentRegistry[id] = result.value;
-    return {.value = id, .error = ErrorCode::SUCCESS};
+    return {.value = pImpl->registerGarment(result.value), .error = ErrorCode::SUCCESS};
   }
   return {.error = result.error, .message = result.message};
 }
 
+/**
+ * URLから衣服を非同期で読み込む
+ */
+void ARFitKit::loadGarmentFromUrlAsync(const std::string &url, GarmentLoadCallback callback) {
+  Impl *impl = pImpl.get();
+  pImpl->garmentConverter->convertFromServerAsync(
+      url, [impl, callback = std::move(callback)](const Result<std::shared_ptr<Garment>> &result) {
+        if (result.isSuccess()) {
+          callback({.value = impl->registerGarment(result.value), .error = ErrorCode::SUCCESS});
+        } else {
+          callback({.error = result.error, .message = result.message});
+        }
+      });
+}
+
 /**
  * 衣服を試着する
  */
@@ -272,11 +458,12 @@ Result<void> ARFitKit::tryOn(const std::string& garmentId) {
     return setupResult;
   }
 
-  // 物理エンジンに追加
+  // 物理エンジンに追加（キャッシュ済みドレープがあればその形状から開始）
   auto physicsResult = pImpl->physicsEngine->addGarment(garment);
   if (!physicsResult) {
     return physicsResult;
   }
+  pImpl->scheduleDrapeBake(garment);
 
   // レンダラーに追加
   auto positions = pImpl->physicsEngine->getParticlePositions(garment);
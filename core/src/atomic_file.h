@@ -0,0 +1,51 @@
+/**
+ * @file atomic_file.h
+ * @brief Replace a file through a temporary sibling and rename (internal)
+ */
+
+#pragma once
+
+#include "types.h"
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace arfit {
+
+/**
+ * @brief Write `path` so that readers never see a partially written file
+ *
+ * The writer fills "<path>.tmp", which is then renamed over `path`. If the
+ * writer fails, the stream cannot be flushed or the rename fails, the
+ * temporary file is removed and `path` is left as it was.
+ *
+ * @param writer Callable taking std::ofstream & and returning Result<void>
+ */
+template <typename Writer>
+Result<void> writeFileAtomically(const std::filesystem::path &path, Writer &&writer) {
+  auto tmpPath = path;
+  tmpPath += ".tmp";
+  std::error_code ec;
+  {
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    auto written = writer(out);
+    if (written && !out.flush()) {
+      written = {.error = ErrorCode::IO_ERROR, .message = "Failed to write file"};
+    }
+    if (!written) {
+      out.close();
+      std::filesystem::remove(tmpPath, ec);
+      return {.error = written.error, .message = written.message + ": " + tmpPath.string()};
+    }
+  }
+
+  std::filesystem::rename(tmpPath, path, ec);
+  if (ec) {
+    std::error_code ignored;
+    std::filesystem::remove(tmpPath, ignored);
+    return {.error = ErrorCode::IO_ERROR, .message = ec.message()};
+  }
+  return {.error = ErrorCode::SUCCESS};
+}
+
+} // namespace arfit
@@ -7,57 +7,1149 @@
  */
 
 #include "body_tracker.h"
+#include "image_preprocess.h"
+#include "landmark_filter.h"
+#include "pose_estimator.h"
+#include "pose_latch.h"
+#include "smpl_model.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <iostream>
-#include <opencv2/opencv.hpp>
+#include <limits>
+#include <mutex>
 
 namespace arfit {
 
 const int MEDIA_PIPE_LANDMARKS = 33;
 
+// 推論領域の余白（外接矩形の長辺に対する割合）
+const float ROI_MARGIN = 0.25f;
+
+// キーフレーム判定用の縮小輝度画像サイズ
+const int MOTION_THUMBNAIL_WIDTH = 32;
+const int MOTION_THUMBNAIL_HEIGHT = 24;
+
+// セグメンテーションで人物を覆うカプセル（MediaPipeランドマークの組）
+const int SEGMENT_NUM_BONES = 13;
+const std::array<std::pair<int, int>, SEGMENT_NUM_BONES> SEGMENT_BONES = {{
+    {11, 12}, {11, 13}, {13, 15}, {12, 14}, {14, 16}, {11, 23}, {12, 24},
+    {23, 24}, {23, 25}, {25, 27}, {24, 26}, {26, 28}, {0, 0}}};
+
+// 差分スキニングで変化なしとみなす許容差（関節回転[rad]、全体の平行移動・スケール）
+const float SKIN_ROTATION_TOLERANCE = 1e-4f;
+const float SKIN_GLOBAL_TOLERANCE = 1e-5f;
+
+// 頂点配列はSIMD幅に合わせて4の倍数にパディング
+const int SMPL_PADDED_VERTICES = (SMPL_NUM_VERTICES + 3) & ~3;
+
+// フィッティングに使うMediaPipeランドマークと対応するSMPL関節
+const int FIT_NUM_TARGETS = 13;
+const std::array<std::pair<int, int>, FIT_NUM_TARGETS> FIT_LANDMARK_JOINTS = {{
+    {0, 15},  {11, 16}, {12, 17}, {13, 18}, {14, 19}, {15, 20}, {16, 21},
+    {23, 1},  {24, 2},  {25, 4},  {26, 5},  {27, 7},  {28, 8}}};
+
+// 回転を推定する関節（上記の関節の祖先のみ、先端関節の回転は観測できない）
+const int FIT_NUM_ROTATIONS = 15;
+const std::array<int, FIT_NUM_ROTATIONS> FIT_ROTATION_JOINTS = {
+    0, 1, 2, 3, 4, 5, 6, 9, 12, 13, 14, 16, 17, 18, 19};
+
+// 最適化変数: 平行移動(3) + 形状(10) + 関節ごとのワールド系微小回転(3)
+const int FIT_NUM_PARAMS = 3 + SMPL_NUM_BETAS + 3 * FIT_NUM_ROTATIONS;
+
+// 事前分布の重み（ポーズ・形状をゼロ近傍に保つ）
+const float FIT_POSE_PRIOR = 1e-4f;
+const float FIT_SHAPE_PRIOR = 1e-3f;
+
+/**
+ * @brief SMPL順伝播の作業領域（人物ごとに持ち、並列に評価できるようにする）
+ */
+struct SMPLWorkspace {
+  // 形状ブレンドシェイプ適用済みの静止メッシュ（betasが変わらない限り再利用）
+  std::vector<float> shapedVertices; // [3][Vp]
+  std::vector<float> posedVertices;  // [3][Vp] 作業領域
+  std::array<Point3D, SMPL_NUM_JOINTS> restJoints;
+  std::array<float, SMPL_NUM_BETAS> shapedBetas;
+  bool hasShapedMesh = false;
+
+  // 直近にスキニングしたパラメータ（差分スキニング用）
+  SMPLParams skinnedParams;
+  bool hasSkinnedParams = false;
+};
+
+/**
+ * @brief 人物ごとの追跡状態
+ */
+struct PersonTrack {
+  int id = -1;
+
+  // 出力ランドマークの平滑化（One-Euro、フレーム時刻基準）
+  LandmarkFilter filter;
+
+  // 直近2キーフレームの姿勢（等速外挿用）
+  BodyPose keyPose;
+  std::array<Point3D, 33> prevKeyLandmarks;
+  float keyTimestamp = 0.0f;
+  float prevKeyTimestamp = 0.0f;
+  uint64_t keyFrameIndex = 0;     // 検出元のフレーム番号
+  uint64_t prevKeyFrameIndex = 0;
+  int numKeyframes = 0;
+  int missedKeyframes = 0;      // 連続して検出と対応付かなかったキーフレーム数
+
+  BodyPose pose; // 現フレームの姿勢
+  SMPLParams fitParams; // 前フレームのフィッティング結果（ウォームスタート用）
+  bool hasFit = false;
+  std::array<Point3D, 33> fittedLandmarks; // 直近のフィッティングに使ったランドマーク
+  SMPLWorkspace workspace;
+};
+
+/**
+ * @brief 関節のみの順運動学（フィッティング用）
+ */
+struct JointKinematics {
+  std::array<std::array<float, 9>, SMPL_NUM_JOINTS> worldR;
+  std::array<Point3D, SMPL_NUM_JOINTS> position; // スケール・平行移動適用後
+  std::array<std::array<Point3D, SMPL_NUM_BETAS>, SMPL_NUM_JOINTS> shapeJacobian;
+};
+
+/**
+ * @brief モデル座標系に変換したフィッティング対象（FIT_LANDMARK_JOINTS の順）
+ */
+struct FitTargets {
+  std::array<Point3D, FIT_NUM_TARGETS> position;
+  std::array<bool, FIT_NUM_TARGETS> visible;
+};
+
+/**
+ * ランドマーク（フレーム正規化座標 [-1, 1]、y下向き、zは手前が負）をSMPLのモデル座標系
+ * （y上向き、手前が+z）へ変換する。x軸まわりの180°回転なので鏡像にはならない。
+ * 大きさの違いは SMPLParams::scale（肩と腰の間隔から推定）が吸収する
+ */
+inline Point3D landmarkToModel(const Point3D &p) { return {p.x, -p.y, -p.z}; }
+
+inline FitTargets makeFitTargets(const BodyPose &pose) {
+  FitTargets targets;
+  for (int i = 0; i < FIT_NUM_TARGETS; ++i) {
+    int landmark = FIT_LANDMARK_JOINTS[i].first;
+    targets.position[i] = landmarkToModel(pose.landmarks[landmark]);
+    targets.visible[i] = pose.visibility[landmark] >= 0.5f;
+  }
+  return targets;
+}
+
+/**
+ * 矩形コスト行列の最小コスト割り当て（ハンガリアン法, O(n^2 m)）
+ * @param cost rows x cols の行優先行列 (rows <= cols)
+ * @return 各行に割り当てた列
+ */
+static std::vector<int> solveAssignment(const std::vector<float> &cost, int rows, int cols) {
+  const float INF = std::numeric_limits<float>::infinity();
+  std::vector<float> u(rows + 1, 0.0f), v(cols + 1, 0.0f), minv(cols + 1);
+  std::vector<int> match(cols + 1, 0), way(cols + 1, 0);
+  std::vector<bool> used(cols + 1);
+
+  for (int i = 1; i <= rows; ++i) {
+    match[0] = i;
+    int j0 = 0;
+    std::fill(minv.begin(), minv.end(), INF);
+    std::fill(used.begin(), used.end(), false);
+    do {
+      used[j0] = true;
+      int i0 = match[j0], j1 = 0;
+      float delta = INF;
+      for (int j = 1; j <= cols; ++j) {
+        if (used[j]) continue;
+        float reduced = cost[(i0 - 1) * cols + (j - 1)] - u[i0] - v[j];
+        if (reduced < minv[j]) {
+          minv[j] = reduced;
+          way[j] = j0;
+        }
+        if (minv[j] < delta) {
+          delta = minv[j];
+          j1 = j;
+        }
+      }
+      for (int j = 0; j <= cols; ++j) {
+        if (used[j]) {
+          u[match[j]] += delta;
+          v[j] -= delta;
+        } else {
+          minv[j] -= delta;
+        }
+      }
+      j0 = j1;
+    } while (match[j0] != 0);
+    do {
+      int j1 = way[j0];
+      match[j0] = match[j1];
+      j0 = j1;
+    } while (j0);
+  }
+
+  std::vector<int> assignment(rows, -1);
+  for (int j = 1; j <= cols; ++j) {
+    if (match[j] > 0) assignment[match[j] - 1] = j - 1;
+  }
+  return assignment;
+}
+
 class BodyTracker::Impl {
 public:
   BodyTrackerConfig config;
   bool initialized = false;
 
-  // SMPLテンプレート頂点（初期Tポーズ）
-  std::vector<Point3D> smplTemplate;
-  
-  // 前フレームのランドマーク（スムージング用）
-  std::array<Point3D, 33> prevLandmarks;
-  bool hasPrevFrame = false;
-  
-  // スムージング係数（0.0=前フレームのみ, 1.0=現在フレームのみ）
-  float smoothingFactor = 0.6f;
+  // SMPLモデル（初期Tポーズのテンプレートとブレンドシェイプ、ファイルからはメモリマップ）
+  std::shared_ptr<SMPLModel> smplModel;
+  SMPLModelData smpl;
 
-  Impl() { initializeSMPLTemplate(); }
+  // getSMPLMesh() 用の作業領域（フレーム処理とアプリのスレッドの両方から呼ばれるため排他する）
+  SMPLWorkspace workspace;
+  std::mutex workspaceMutex;
 
-  void initializeSMPLTemplate() {
-    // SMPLの基本テンプレート (6890頂点) を初期化
-    // 実際の製品ではSMPLモデルファイル(.pkl)をロードする
-    smplTemplate.resize(6890);
-    for (auto &v : smplTemplate) {
-      v = {0.0f, 0.0f, 0.0f};
+  // 形状に対する関節位置の線形モデル J(β) = J0 + Σ β_k dJ_k（関節回帰から事前計算）
+  std::array<Point3D, SMPL_NUM_JOINTS> templateJoints;
+  std::array<std::array<Point3D, SMPL_NUM_BETAS>, SMPL_NUM_JOINTS> jointShapeDirs;
+  std::array<uint32_t, SMPL_NUM_JOINTS> ancestorMask; // 各関節の祖先関節のビット
+  std::vector<uint32_t> groupPoseMask; // 頂点グループにポーズブレンドシェイプが及ぶ関節のビット
+  bool hasJointRegressor = false;
+
+  // 追跡中の人物（IDの昇順）
+  std::vector<PersonTrack> tracks;
+  int nextTrackId = 0;
+
+  // キーフレームスケジューリング（推論を間引き、間のフレームは等速外挿）
+  std::vector<uint8_t> keyThumbnail;     // 直近キーフレームの縮小輝度画像
+  std::vector<uint8_t> currentThumbnail; // 作業領域
+  std::vector<BodyPose> detections;      // キーフレームの検出結果
+  int framesSinceKeyframe = 0;
+  int numKeyframes = 0;
+  uint64_t frameIndex = 0;
+
+  // 姿勢推定バックエンド（非同期、投入済みで未回収の推論を1つまで保持）
+  std::shared_ptr<IPoseEstimator> estimator;
+  uint64_t pendingTicket = 0;
+  uint64_t pendingFrameIndex = 0;
+  float pendingTimestamp = 0.0f;
+  LetterboxTransform pendingTransform;
+  bool hasPending = false;
+  LetterboxResampler resampler;
+
+  // 描画側へ最新の姿勢を渡すラッチ（任意）
+  std::shared_ptr<PoseLatch> poseLatch;
+
+  Impl() { setModel(SMPLModel::createPlaceholder()); }
+
+  void setModel(std::shared_ptr<SMPLModel> model) {
+    smplModel = std::move(model);
+    smpl = smplModel->data();
+
+    {
+      std::lock_guard<std::mutex> lock(workspaceMutex);
+      workspace.hasShapedMesh = false;
+      workspace.hasSkinnedParams = false;
+    }
+    for (auto &track : tracks) {
+      track.workspace.hasShapedMesh = false;
+      track.workspace.hasSkinnedParams = false;
     }
+    prepareJointModel();
+    preparePoseDirMask();
   }
 
-  float distance(const Point3D &a, const Point3D &b) {
-    float dx = a.x - b.x;
-    float dy = a.y - b.y;
-    float dz = a.z - b.z;
-    return std::sqrt(dx * dx + dy * dy + dz * dz);
+  /**
+   * 頂点グループごとに、ポーズブレンドシェイプが非ゼロの関節のビットを求める
+   * （差分スキニングで関節回転の変化が及ぶ頂点を正確に絞り込むため）
+   */
+  void preparePoseDirMask() {
+    const size_t Vp = SMPL_PADDED_VERTICES;
+    const size_t planes = 3 * Vp;
+    groupPoseMask.assign(Vp / 4, 0);
+    for (int f = 0; f < SMPL_NUM_POSE_FEATURES; ++f) {
+      uint32_t bit = 1u << (f / 9 + 1);
+      const float *dirs = smpl.poseDirs + f * planes;
+      for (size_t c = 0; c < 3; ++c) {
+        for (size_t v = 0; v < Vp; ++v) {
+          if (dirs[c * Vp + v] != 0.0f) groupPoseMask[v / 4] |= bit;
+        }
+      }
+    }
+  }
+
+  /**
+   * 関節回帰をテンプレートと形状ブレンドシェイプに適用しておく
+   */
+  void prepareJointModel() {
+    const size_t Vp = SMPL_PADDED_VERTICES;
+    const size_t planes = 3 * Vp;
+    hasJointRegressor = smpl.regressorRowStart[SMPL_NUM_JOINTS] > 0;
+    for (int j = 0; j < SMPL_NUM_JOINTS; ++j) {
+      Point3D joint;
+      std::array<Point3D, SMPL_NUM_BETAS> dirs{};
+      for (int e = smpl.regressorRowStart[j]; e < smpl.regressorRowStart[j + 1]; ++e) {
+        size_t v = smpl.regressorVertex[e];
+        float w = smpl.regressorWeight[e];
+        const float *t = smpl.templateVertices;
+        joint = joint + Point3D{t[v], t[Vp + v], t[2 * Vp + v]} * w;
+        for (int k = 0; k < SMPL_NUM_BETAS; ++k) {
+          const float *d = smpl.shapeDirs + k * planes;
+          dirs[k] = dirs[k] + Point3D{d[v], d[Vp + v], d[2 * Vp + v]} * w;
+        }
+      }
+      templateJoints[j] = joint;
+      jointShapeDirs[j] = dirs;
+
+      int parent = smpl.parents[j];
+      ancestorMask[j] = parent < 0 ? 0u : ancestorMask[parent] | (1u << parent);
+    }
+  }
+
+  /**
+   * 形状ブレンドシェイプ (T + S·β) と関節回帰 (J = R·v) を適用
+   */
+  void updateShapedMesh(SMPLWorkspace &ws, const std::array<float, SMPL_NUM_BETAS> &betas) {
+    if (ws.hasShapedMesh && betas == ws.shapedBetas) return;
+
+    const size_t planes = 3 * (size_t)SMPL_PADDED_VERTICES;
+    if (ws.shapedVertices.size() != planes) {
+      ws.shapedVertices.assign(planes, 0.0f);
+      ws.posedVertices.assign(planes, 0.0f);
+    }
+    auto &shapedVertices = ws.shapedVertices;
+    ThreadPool::shared().parallelFor(0, planes / 4, 256, [&](size_t begin, size_t end) {
+      size_t offset = begin * 4, length = (end - begin) * 4;
+      std::copy_n(smpl.templateVertices + offset, length, &shapedVertices[offset]);
+      for (int k = 0; k < SMPL_NUM_BETAS; ++k) {
+        if (betas[k] == 0.0f) continue;
+        simd::axpy(betas[k], smpl.shapeDirs + k * planes + offset, &shapedVertices[offset], length);
+      }
+    });
+
+    const float *xs = &shapedVertices[0];
+    const float *ys = &shapedVertices[SMPL_PADDED_VERTICES];
+    const float *zs = &shapedVertices[2 * SMPL_PADDED_VERTICES];
+    for (int j = 0; j < SMPL_NUM_JOINTS; ++j) {
+      Point3D joint;
+      for (int e = smpl.regressorRowStart[j]; e < smpl.regressorRowStart[j + 1]; ++e) {
+        int v = smpl.regressorVertex[e];
+        float w = smpl.regressorWeight[e];
+        joint = joint + Point3D{xs[v], ys[v], zs[v]} * w;
+      }
+      ws.restJoints[j] = joint;
+    }
+
+    ws.shapedBetas = betas;
+    ws.hasShapedMesh = true;
+  }
+
+  /**
+   * 軸角ベクトルから回転行列（行優先3x3）へ変換
+   */
+  static void rodrigues(const float *aa, float *R) {
+    float theta = std::sqrt(aa[0] * aa[0] + aa[1] * aa[1] + aa[2] * aa[2]);
+    if (theta < 1e-8f) {
+      const float I[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+      std::copy(I, I + 9, R);
+      return;
+    }
+    float x = aa[0] / theta, y = aa[1] / theta, z = aa[2] / theta;
+    float c = std::cos(theta), s = std::sin(theta), t = 1.0f - c;
+    R[0] = t * x * x + c;     R[1] = t * x * y - s * z; R[2] = t * x * z + s * y;
+    R[3] = t * x * y + s * z; R[4] = t * y * y + c;     R[5] = t * y * z - s * x;
+    R[6] = t * x * z - s * y; R[7] = t * y * z + s * x; R[8] = t * z * z + c;
+  }
+
+  /**
+   * 回転行列から軸角ベクトルへ変換（rodriguesの逆）
+   */
+  static void rotationToAxisAngle(const float *R, float *aa) {
+    // θ は atan2 で求める（π付近では cos からの逆算は精度が落ちる）
+    float sx = (R[7] - R[5]) * 0.5f, sy = (R[2] - R[6]) * 0.5f, sz = (R[3] - R[1]) * 0.5f;
+    float sinTheta = std::sqrt(sx * sx + sy * sy + sz * sz);
+    float cosTheta = (R[0] + R[4] + R[8] - 1.0f) * 0.5f;
+    float theta = std::atan2(sinTheta, cosTheta);
+    if (sinTheta > 1e-5f || cosTheta > 0.0f) {
+      float k = sinTheta > 1e-12f ? theta / sinTheta : 1.0f;
+      aa[0] = sx * k;
+      aa[1] = sy * k;
+      aa[2] = sz * k;
+      return;
+    }
+    // θ ≈ π: 対角成分から軸を求める
+    float x = std::sqrt(std::max(0.0f, (R[0] + 1.0f) * 0.5f));
+    float y = std::sqrt(std::max(0.0f, (R[4] + 1.0f) * 0.5f));
+    float z = std::sqrt(std::max(0.0f, (R[8] + 1.0f) * 0.5f));
+    if (x >= y && x >= z) {
+      y = std::copysign(y, R[1]);
+      z = std::copysign(z, R[2]);
+    } else if (y >= z) {
+      x = std::copysign(x, R[1]);
+      z = std::copysign(z, R[5]);
+    } else {
+      x = std::copysign(x, R[2]);
+      y = std::copysign(y, R[5]);
+    }
+    aa[0] = x * theta;
+    aa[1] = y * theta;
+    aa[2] = z * theta;
   }
-  
+
   /**
-   * ランドマークのスムージング（ジッター軽減）
+   * 関節のワールド回転・位置と、形状に対する関節位置のヤコビアンを計算
    */
-  Point3D smoothLandmark(const Point3D& current, const Point3D& prev) {
-    return {
-        prev.x + (current.x - prev.x) * smoothingFactor,
-        prev.y + (current.y - prev.y) * smoothingFactor,
-        prev.z + (current.z - prev.z) * smoothingFactor
+  void computeJointKinematics(const SMPLParams &params, JointKinematics &k) const {
+    std::array<Point3D, SMPL_NUM_JOINTS> rest;
+    for (int j = 0; j < SMPL_NUM_JOINTS; ++j) {
+      rest[j] = templateJoints[j];
+      for (int b = 0; b < SMPL_NUM_BETAS; ++b) rest[j] = rest[j] + jointShapeDirs[j][b] * params.shape[b];
+    }
+
+    const Point3D translation = {params.translation[0], params.translation[1], params.translation[2]};
+    std::array<Point3D, SMPL_NUM_JOINTS> world;
+    for (int j = 0; j < SMPL_NUM_JOINTS; ++j) {
+      std::array<float, 9> R;
+      rodrigues(&params.pose[j * 3], R.data());
+      int parent = smpl.parents[j];
+      if (parent < 0) {
+        k.worldR[j] = R;
+        world[j] = rest[j];
+        for (int b = 0; b < SMPL_NUM_BETAS; ++b) k.shapeJacobian[j][b] = jointShapeDirs[j][b] * params.scale;
+      } else {
+        const auto &P = k.worldR[parent];
+        for (int r = 0; r < 3; ++r)
+          for (int c = 0; c < 3; ++c)
+            k.worldR[j][r * 3 + c] = P[r * 3] * R[c] + P[r * 3 + 1] * R[3 + c] + P[r * 3 + 2] * R[6 + c];
+        auto rotate = [&](const Point3D &v) {
+          return Point3D{P[0] * v.x + P[1] * v.y + P[2] * v.z, P[3] * v.x + P[4] * v.y + P[5] * v.z,
+                         P[6] * v.x + P[7] * v.y + P[8] * v.z};
+        };
+        world[j] = world[parent] + rotate(rest[j] - rest[parent]);
+        for (int b = 0; b < SMPL_NUM_BETAS; ++b) {
+          k.shapeJacobian[j][b] = k.shapeJacobian[parent][b] +
+                                  rotate(jointShapeDirs[j][b] - jointShapeDirs[parent][b]) * params.scale;
+        }
+      }
+      k.position[j] = world[j] * params.scale + translation;
+    }
+  }
+
+  /**
+   * ランドマークとの残差二乗和（事前項を含む）
+   */
+  float fittingCost(const SMPLParams &params, const FitTargets &targets, JointKinematics &k) const {
+    computeJointKinematics(params, k);
+    float cost = 0.0f;
+    for (int i = 0; i < FIT_NUM_TARGETS; ++i) {
+      if (!targets.visible[i]) continue;
+      Point3D d = k.position[FIT_LANDMARK_JOINTS[i].second] - targets.position[i];
+      cost += d.x * d.x + d.y * d.y + d.z * d.z;
+    }
+    for (int joint : FIT_ROTATION_JOINTS) {
+      if (joint == 0) continue; // 全体の向きは拘束しない
+      for (int c = 0; c < 3; ++c) cost += FIT_POSE_PRIOR * params.pose[joint * 3 + c] * params.pose[joint * 3 + c];
+    }
+    for (float beta : params.shape) cost += FIT_SHAPE_PRIOR * beta * beta;
+    return cost;
+  }
+
+  /**
+   * 密な対称正定値行列の Cholesky 分解による求解（A は破壊される）
+   */
+  static bool solveDense(std::vector<float> &A, std::vector<float> &b, int n) {
+    for (int i = 0; i < n; ++i) {
+      for (int j = 0; j <= i; ++j) {
+        float s = A[i * n + j];
+        for (int k = 0; k < j; ++k) s -= A[i * n + k] * A[j * n + k];
+        if (i == j) {
+          if (s <= 0.0f) return false;
+          A[i * n + i] = std::sqrt(s);
+        } else {
+          A[i * n + j] = s / A[j * n + j];
+        }
+      }
+    }
+    for (int i = 0; i < n; ++i) {
+      for (int k = 0; k < i; ++k) b[i] -= A[i * n + k] * b[k];
+      b[i] /= A[i * n + i];
+    }
+    for (int i = n - 1; i >= 0; --i) {
+      for (int k = i + 1; k < n; ++k) b[i] -= A[k * n + i] * b[k];
+      b[i] /= A[i * n + i];
+    }
+    return true;
+  }
+
+  /**
+   * Levenberg-Marquardt による平行移動・形状・関節回転の最適化
+   *
+   * 関節 a の回転はワールド座標系の微小回転 ω で更新するため、子孫関節 j の
+   * 位置のヤコビアンは ∂p_j/∂ω = -[p_j - p_a]× と解析的に求まる。
+   * 前フレームの結果から始めれば 1〜3 反復で収束する。
+   */
+  void refineSMPL(const BodyPose &pose, SMPLParams &params) const {
+    if (!hasJointRegressor || config.fitMaxIterations <= 0) return;
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<float, std::milli>(config.fitTimeBudgetMs));
+
+    const int n = FIT_NUM_PARAMS;
+    const int shapeOffset = 3, rotationOffset = 3 + SMPL_NUM_BETAS;
+    std::vector<float> JtJ(n * n), A(n * n), g(n), delta(n);
+    // 残差はモデル座標系で取る（ランドマークの軸の向きを先に揃える）
+    const FitTargets targets = makeFitTargets(pose);
+    JointKinematics k, trial;
+    float cost = fittingCost(params, targets, k);
+    float lambda = 1e-3f;
+
+    for (int iter = 0; iter < config.fitMaxIterations; ++iter) {
+      // 正規方程式 JᵀJ δ = -Jᵀr の組み立て
+      std::fill(JtJ.begin(), JtJ.end(), 0.0f);
+      std::fill(g.begin(), g.end(), 0.0f);
+      for (int t = 0; t < FIT_NUM_TARGETS; ++t) {
+        if (!targets.visible[t]) continue;
+        const int joint = FIT_LANDMARK_JOINTS[t].second;
+        Point3D r = k.position[joint] - targets.position[t];
+        const float residual[3] = {r.x, r.y, r.z};
+
+        // この残差に効く変数の列（最大 3 + 10 + 3*15）
+        int columns[FIT_NUM_PARAMS];
+        float jac[3][FIT_NUM_PARAMS];
+        int m = 0;
+        for (int c = 0; c < 3; ++c, ++m) {
+          columns[m] = c;
+          for (int row = 0; row < 3; ++row) jac[row][m] = row == c ? 1.0f : 0.0f;
+        }
+        for (int b = 0; b < SMPL_NUM_BETAS; ++b, ++m) {
+          const Point3D &d = k.shapeJacobian[joint][b];
+          columns[m] = shapeOffset + b;
+          jac[0][m] = d.x;
+          jac[1][m] = d.y;
+          jac[2][m] = d.z;
+        }
+        for (int a = 0; a < FIT_NUM_ROTATIONS; ++a) {
+          int ancestor = FIT_ROTATION_JOINTS[a];
+          if (!(ancestorMask[joint] & (1u << ancestor))) continue;
+          Point3D d = k.position[joint] - k.position[ancestor];
+          // ω × d = -[d]× ω
+          const float skew[3][3] = {{0.0f, d.z, -d.y}, {-d.z, 0.0f, d.x}, {d.y, -d.x, 0.0f}};
+          for (int c = 0; c < 3; ++c, ++m) {
+            columns[m] = rotationOffset + a * 3 + c;
+            for (int row = 0; row < 3; ++row) jac[row][m] = skew[row][c];
+          }
+        }
+
+        for (int p = 0; p < m; ++p) {
+          float *rowOut = &JtJ[columns[p] * n];
+          for (int q = 0; q <= p; ++q) {
+            rowOut[columns[q]] += jac[0][p] * jac[0][q] + jac[1][p] * jac[1][q] + jac[2][p] * jac[2][q];
+          }
+          g[columns[p]] += jac[0][p] * residual[0] + jac[1][p] * residual[1] + jac[2][p] * residual[2];
+        }
+      }
+      // 事前項（軸角の微小変化は局所的にωと一致するとみなす）
+      for (int a = 0; a < FIT_NUM_ROTATIONS; ++a) {
+        int joint = FIT_ROTATION_JOINTS[a];
+        if (joint == 0) continue;
+        for (int c = 0; c < 3; ++c) {
+          int i = rotationOffset + a * 3 + c;
+          JtJ[i * n + i] += FIT_POSE_PRIOR;
+          g[i] += FIT_POSE_PRIOR * params.pose[joint * 3 + c];
+        }
+      }
+      for (int b = 0; b < SMPL_NUM_BETAS; ++b) {
+        int i = shapeOffset + b;
+        JtJ[i * n + i] += FIT_SHAPE_PRIOR;
+        g[i] += FIT_SHAPE_PRIOR * params.shape[b];
+      }
+      // 下三角から上三角へ（columns は昇順なので下三角に集まっている）
+      for (int i = 0; i < n; ++i)
+        for (int j = 0; j < i; ++j) JtJ[j * n + i] = JtJ[i * n + j];
+
+      // 減衰を調整しながら改善するステップを探す
+      bool improved = false;
+      while (!improved && std::chrono::steady_clock::now() < deadline) {
+        A = JtJ;
+        for (int i = 0; i < n; ++i) {
+          A[i * n + i] += lambda * A[i * n + i] + 1e-8f;
+          delta[i] = -g[i];
+        }
+        if (solveDense(A, delta, n)) {
+          SMPLParams candidate = params;
+          applyFitStep(delta, k, candidate);
+          float candidateCost = fittingCost(candidate, targets, trial);
+          if (candidateCost < cost) {
+            improved = true;
+            float reduction = (cost - candidateCost) / std::max(cost, 1e-12f);
+            params = candidate;
+            cost = candidateCost;
+            std::swap(k, trial);
+            lambda = std::max(lambda * 0.3f, 1e-7f);
+            if (reduction < 1e-4f) return; // 収束
+            break;
+          }
+        }
+        lambda *= 4.0f;
+        if (lambda > 1e4f) return;
+      }
+      if (!improved || std::chrono::steady_clock::now() >= deadline) return;
+    }
+  }
+
+  /**
+   * 最適化ステップを適用（回転は親のワールド回転で局所系に戻して左から掛ける）
+   */
+  void applyFitStep(const std::vector<float> &delta, const JointKinematics &k,
+                    SMPLParams &params) const {
+    for (int c = 0; c < 3; ++c) params.translation[c] += delta[c];
+    for (int b = 0; b < SMPL_NUM_BETAS; ++b) params.shape[b] += delta[3 + b];
+    for (int a = 0; a < FIT_NUM_ROTATIONS; ++a) {
+      int joint = FIT_ROTATION_JOINTS[a];
+      const float *w = &delta[3 + SMPL_NUM_BETAS + a * 3];
+      float local[3] = {w[0], w[1], w[2]};
+      int parent = smpl.parents[joint];
+      if (parent >= 0) {
+        const auto &P = k.worldR[parent];
+        for (int r = 0; r < 3; ++r) local[r] = P[r] * w[0] + P[3 + r] * w[1] + P[6 + r] * w[2];
+      }
+      float dR[9], R[9], updated[9];
+      rodrigues(local, dR);
+      rodrigues(&params.pose[joint * 3], R);
+      for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c)
+          updated[r * 3 + c] = dR[r * 3] * R[c] + dR[r * 3 + 1] * R[3 + c] + dR[r * 3 + 2] * R[6 + c];
+      rotationToAxisAngle(updated, &params.pose[joint * 3]);
+    }
+  }
+
+  /**
+   * 前回スキニングしたパラメータから変化した関節のマスク
+   * （スケール・形状が変わった場合は全関節。平行移動は剛体オフセットとして別に扱い、
+   *  許容差を超えた場合のみ translated を立てる）
+   */
+  uint32_t changedJoints(const SMPLWorkspace &ws, const SMPLParams &params, uint32_t &rotatedJoints,
+                         bool &translated) const {
+    const uint32_t ALL = (1u << SMPL_NUM_JOINTS) - 1;
+    rotatedJoints = ALL;
+    translated = false;
+    if (!ws.hasSkinnedParams) return ALL;
+    const SMPLParams &prev = ws.skinnedParams;
+    auto differs = [](const float *a, const float *b, int n, float tolerance) {
+      for (int i = 0; i < n; ++i) {
+        if (std::abs(a[i] - b[i]) > tolerance) return true;
+      }
+      return false;
     };
+    if (differs(&prev.scale, &params.scale, 1, SKIN_GLOBAL_TOLERANCE) || prev.shape != params.shape) {
+      return ALL;
+    }
+    translated = differs(prev.translation.data(), params.translation.data(), 3, SKIN_GLOBAL_TOLERANCE);
+    uint32_t changed = 0;
+    rotatedJoints = 0;
+    for (int j = 0; j < SMPL_NUM_JOINTS; ++j) {
+      int parent = smpl.parents[j];
+      bool rotated = differs(&prev.pose[j * 3], &params.pose[j * 3], 3, SKIN_ROTATION_TOLERANCE);
+      if (rotated) rotatedJoints |= 1u << j;
+      // 親が動けば子のワールド変換も変わる（parents[j] < j）
+      if (rotated || (parent >= 0 && (changed & (1u << parent)))) changed |= 1u << j;
+    }
+    return changed;
+  }
+
+  /**
+   * SMPLの順伝播（ポーズブレンドシェイプ + 線形ブレンドスキニング）
+   * 頂点ブロック単位で並列化し、結果を呼び出し側のバッファに書き込む
+   * @param incremental out が前回この作業領域で生成したメッシュを保持している場合、
+   *        変化した関節の影響を受ける頂点グループのみ再スキニングし、残りは平行移動の差分だけ
+   *        ずらす（許容差内の回転は前回の値を保つため、結果は全体の再計算と厳密には一致しない）
+   */
+  void forwardSMPL(SMPLWorkspace &ws, const SMPLParams &params, std::vector<Point3D> &out,
+                   bool incremental = false) {
+    const uint32_t ALL = (1u << SMPL_NUM_JOINTS) - 1;
+    uint32_t changed = ALL, rotated = ALL;
+    bool translated = false;
+    if (incremental && out.size() == (size_t)SMPL_NUM_VERTICES) {
+      changed = changedJoints(ws, params, rotated, translated);
+    }
+    if (!changed && !translated) return;
+
+    // 再スキニングしない頂点は前回の平行移動で配置されている
+    const Point3D offset{params.translation[0] - ws.skinnedParams.translation[0],
+                         params.translation[1] - ws.skinnedParams.translation[1],
+                         params.translation[2] - ws.skinnedParams.translation[2]};
+    auto translateGroups = [&](size_t begin, size_t end) {
+      size_t last = std::min<size_t>(end * 4, SMPL_NUM_VERTICES);
+      for (size_t v = begin * 4; v < last; ++v) out[v] = out[v] + offset;
+    };
+
+    // 許容差内の関節は前回の値を基準に残す（小さな変化が積み重なれば更新される）
+    if (changed == ALL) {
+      ws.skinnedParams = params;
+    } else {
+      for (int j = 0; j < SMPL_NUM_JOINTS; ++j) {
+        if (rotated & (1u << j)) std::copy_n(&params.pose[j * 3], 3, &ws.skinnedParams.pose[j * 3]);
+      }
+      if (translated) ws.skinnedParams.translation = params.translation;
+    }
+    ws.hasSkinnedParams = true;
+
+    // 平行移動のみ: スキニング行列を組まずに全頂点を剛体移動する
+    if (!changed) {
+      ThreadPool::shared().parallelFor(0, SMPL_PADDED_VERTICES / 4, 64, translateGroups);
+      return;
+    }
+
+    updateShapedMesh(ws, params.shape);
+    const auto &restJoints = ws.restJoints;
+    const auto &shapedVertices = ws.shapedVertices;
+    auto &posedVertices = ws.posedVertices;
+
+    // 各関節の局所回転
+    std::array<std::array<float, 9>, SMPL_NUM_JOINTS> R;
+    for (int j = 0; j < SMPL_NUM_JOINTS; ++j) rodrigues(&params.pose[j * 3], R[j].data());
+
+    // ポーズ特徴量 (R - I)、ゼロでないものだけをブレンドする
+    std::array<float, SMPL_NUM_POSE_FEATURES> features;
+    std::array<int, SMPL_NUM_POSE_FEATURES> activeFeatures;
+    int numActive = 0;
+    for (int j = 1; j < SMPL_NUM_JOINTS; ++j) {
+      for (int e = 0; e < 9; ++e) {
+        int f = (j - 1) * 9 + e;
+        features[f] = R[j][e] - ((e % 4 == 0) ? 1.0f : 0.0f);
+        if (std::abs(features[f]) > 1e-7f) activeFeatures[numActive++] = f;
+      }
+    }
+
+    // 運動学チェーンに沿ったワールド変換とスキニング行列 (3x4, 行優先)
+    std::array<std::array<float, 9>, SMPL_NUM_JOINTS> worldR;
+    std::array<Point3D, SMPL_NUM_JOINTS> worldT;
+    std::array<std::array<simd::Float4, 12>, SMPL_NUM_JOINTS> skinning;
+    for (int j = 0; j < SMPL_NUM_JOINTS; ++j) {
+      int parent = smpl.parents[j];
+      if (parent < 0) {
+        worldR[j] = R[j];
+        worldT[j] = restJoints[j];
+      } else {
+        const auto &P = worldR[parent];
+        for (int r = 0; r < 3; ++r)
+          for (int c = 0; c < 3; ++c)
+            worldR[j][r * 3 + c] = P[r * 3] * R[j][c] + P[r * 3 + 1] * R[j][3 + c] + P[r * 3 + 2] * R[j][6 + c];
+        Point3D bone = restJoints[j] - restJoints[parent];
+        worldT[j] = worldT[parent] + Point3D{P[0] * bone.x + P[1] * bone.y + P[2] * bone.z,
+                                             P[3] * bone.x + P[4] * bone.y + P[5] * bone.z,
+                                             P[6] * bone.x + P[7] * bone.y + P[8] * bone.z};
+      }
+
+      // 静止姿勢の関節位置を差し引き、全体のスケールと平行移動を畳み込む
+      const auto &W = worldR[j];
+      const Point3D &J = restJoints[j];
+      const float worldTranslation[3] = {worldT[j].x, worldT[j].y, worldT[j].z};
+      for (int r = 0; r < 3; ++r) {
+        const float *row = &W[r * 3];
+        float t = worldTranslation[r] - (row[0] * J.x + row[1] * J.y + row[2] * J.z);
+        skinning[j][r * 4 + 0] = simd::splat(row[0] * params.scale);
+        skinning[j][r * 4 + 1] = simd::splat(row[1] * params.scale);
+        skinning[j][r * 4 + 2] = simd::splat(row[2] * params.scale);
+        skinning[j][r * 4 + 3] = simd::splat(t * params.scale + params.translation[r]);
+      }
+    }
+
+    if (out.size() != (size_t)SMPL_NUM_VERTICES) out.resize(SMPL_NUM_VERTICES);
+
+    const size_t Vp = SMPL_PADDED_VERTICES;
+    const size_t planes = 3 * Vp;
+    const bool everyGroup = changed == ALL;
+    auto skinGroups = [&](size_t begin, size_t end) {
+      size_t v0 = begin * 4, length = (end - begin) * 4;
+
+      // ポーズブレンドシェイプ (GEMV: 3V x 207 のうち非ゼロ列のみ)
+      for (size_t c = 0; c < 3; ++c) {
+        float *dst = &posedVertices[c * Vp + v0];
+        std::copy_n(&shapedVertices[c * Vp + v0], length, dst);
+        for (int a = 0; a < numActive; ++a) {
+          int f = activeFeatures[a];
+          simd::axpy(features[f], smpl.poseDirs + f * planes + c * Vp + v0, dst, length);
+        }
+      }
+
+      // 線形ブレンドスキニング（影響する関節のみ累積）
+      alignas(16) float ox[4], oy[4], oz[4];
+      for (size_t g = begin; g < end; ++g) {
+        size_t v = g * 4;
+        std::array<simd::Float4, 12> M;
+        M.fill(simd::zero());
+        uint32_t mask = smpl.groupJointMask[g];
+        for (int j = 0; j < SMPL_NUM_JOINTS && mask; ++j) {
+          if (!(mask & (1u << j))) continue;
+          mask &= ~(1u << j);
+          simd::Float4 w = simd::load(smpl.skinWeights + j * Vp + v);
+          for (int e = 0; e < 12; ++e) M[e] = simd::madd(w, skinning[j][e], M[e]);
+        }
+
+        simd::Float4 px = simd::load(&posedVertices[v]);
+        simd::Float4 py = simd::load(&posedVertices[Vp + v]);
+        simd::Float4 pz = simd::load(&posedVertices[2 * Vp + v]);
+        simd::store(ox, simd::madd(M[0], px, simd::madd(M[1], py, simd::madd(M[2], pz, M[3]))));
+        simd::store(oy, simd::madd(M[4], px, simd::madd(M[5], py, simd::madd(M[6], pz, M[7]))));
+        simd::store(oz, simd::madd(M[8], px, simd::madd(M[9], py, simd::madd(M[10], pz, M[11]))));
+
+        size_t count = std::min<size_t>(4, SMPL_NUM_VERTICES - v);
+        for (size_t i = 0; i < count; ++i) out[v + i] = {ox[i], oy[i], oz[i]};
+      }
+    };
+
+    ThreadPool::shared().parallelFor(0, Vp / 4, 64, [&](size_t begin, size_t end) {
+      if (everyGroup) {
+        skinGroups(begin, end);
+        return;
+      }
+      // スキニング行列かポーズブレンドシェイプが変わる連続したグループ単位で更新
+      auto affected = [&](size_t g) {
+        return (smpl.groupJointMask[g] & changed) || (groupPoseMask[g] & rotated);
+      };
+      size_t g = begin;
+      while (g < end) {
+        size_t runStart = g;
+        while (g < end && !affected(g)) ++g;
+        if (translated && g > runStart) translateGroups(runStart, g);
+        runStart = g;
+        while (g < end && affected(g)) ++g;
+        if (g > runStart) skinGroups(runStart, g);
+      }
+    });
+  }
+
+  /**
+   * フレームを縮小輝度画像に点サンプリング（動き検出用、数百画素のみ参照）
+   */
+  static bool computeThumbnail(const ImageData &image, std::vector<uint8_t> &thumbnail) {
+    if (image.width <= 0 || image.height <= 0 || image.channels <= 0 ||
+        image.pixels.size() < (size_t)image.width * image.height * image.channels) {
+      return false;
+    }
+    thumbnail.resize(MOTION_THUMBNAIL_WIDTH * MOTION_THUMBNAIL_HEIGHT);
+    for (int ty = 0; ty < MOTION_THUMBNAIL_HEIGHT; ++ty) {
+      int y = (2 * ty + 1) * image.height / (2 * MOTION_THUMBNAIL_HEIGHT);
+      for (int tx = 0; tx < MOTION_THUMBNAIL_WIDTH; ++tx) {
+        int x = (2 * tx + 1) * image.width / (2 * MOTION_THUMBNAIL_WIDTH);
+        const uint8_t *p = &image.pixels[((size_t)y * image.width + x) * image.channels];
+        thumbnail[ty * MOTION_THUMBNAIL_WIDTH + tx] =
+            image.channels >= 3 ? (uint8_t)((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8) : p[0];
+      }
+    }
+    return true;
+  }
+
+  /**
+   * 縮小画像間の平均絶対差 (0-1)
+   */
+  static float motionScore(const std::vector<uint8_t> &a, const std::vector<uint8_t> &b) {
+    int sum = 0;
+    for (size_t i = 0; i < a.size(); ++i) sum += std::abs((int)a[i] - (int)b[i]);
+    return (float)sum / (255.0f * a.size());
+  }
+
+  /**
+   * このフレームで姿勢推定を実行するか判定
+   */
+  bool isKeyframe(const CameraFrame &frame) {
+    bool hasThumbnail = computeThumbnail(frame.image, currentThumbnail);
+    if (numKeyframes == 0 || config.keyframeInterval <= 1) return true;
+    if (framesSinceKeyframe + 1 >= config.keyframeInterval) return true;
+    if (!hasThumbnail || keyThumbnail.size() != currentThumbnail.size()) return true;
+    return motionScore(currentThumbnail, keyThumbnail) > config.motionThreshold;
+  }
+
+  /**
+   * キーフレームの姿勢を人物ごとに記録
+   */
+  void recordKeyframe(PersonTrack &track, const BodyPose &pose, float timestamp,
+                      uint64_t sourceFrame) {
+    track.prevKeyLandmarks = track.keyPose.landmarks;
+    track.prevKeyTimestamp = track.keyTimestamp;
+    track.prevKeyFrameIndex = track.keyFrameIndex;
+    track.keyPose = pose;
+    track.keyTimestamp = timestamp;
+    track.keyFrameIndex = sourceFrame;
+    track.missedKeyframes = 0;
+    ++track.numKeyframes;
+    track.pose = pose;
+  }
+
+  /**
+   * 直近2キーフレームから等速モデルでランドマークを外挿
+   */
+  void extrapolatePose(PersonTrack &track, float timestamp) {
+    track.pose = track.keyPose;
+    if (track.numKeyframes < 2) return;
+
+    // タイムスタンプが使えなければフレーム数で進める
+    float keyInterval = track.keyTimestamp - track.prevKeyTimestamp;
+    float ratio = keyInterval > 0.0f && timestamp > track.keyTimestamp
+                      ? (timestamp - track.keyTimestamp) / keyInterval
+                      : (float)(frameIndex - track.keyFrameIndex) /
+                            std::max<uint64_t>(track.keyFrameIndex - track.prevKeyFrameIndex, 1);
+    for (int i = 0; i < MEDIA_PIPE_LANDMARKS; ++i) {
+      const Point3D &key = track.keyPose.landmarks[i];
+      track.pose.landmarks[i] = key + (key - track.prevKeyLandmarks[i]) * ratio;
+    }
+  }
+
+  /**
+   * 推論する領域（前フレームの姿勢の外接矩形、見失っている人物がいれば全体）
+   */
+  CropRegion regionOfInterest(const ImageData &image) const {
+    CropRegion full{0.0f, 0.0f, (float)image.width, (float)image.height};
+    if (tracks.empty() || (int)tracks.size() < std::max(config.numPoses, 1)) return full;
+
+    float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f;
+    for (const auto &track : tracks) {
+      if (track.missedKeyframes > 0) return full;
+      for (int i = 0; i < MEDIA_PIPE_LANDMARKS; ++i) {
+        if (track.pose.visibility[i] < 0.5f) continue;
+        const Point3D &p = track.pose.landmarks[i];
+        minX = std::min(minX, p.x);
+        maxX = std::max(maxX, p.x);
+        minY = std::min(minY, p.y);
+        maxY = std::max(maxY, p.y);
+      }
+    }
+    if (maxX <= minX || maxY <= minY) return full;
+
+    // 正規化座標からピクセルへ変換し、動きに備えて余白を付ける
+    float x0 = (minX + 1.0f) * 0.5f * image.width, x1 = (maxX + 1.0f) * 0.5f * image.width;
+    float y0 = (minY + 1.0f) * 0.5f * image.height, y1 = (maxY + 1.0f) * 0.5f * image.height;
+    float margin = ROI_MARGIN * std::max(x1 - x0, y1 - y0);
+    x0 = std::max(0.0f, x0 - margin);
+    y0 = std::max(0.0f, y0 - margin);
+    x1 = std::min((float)image.width, x1 + margin);
+    y1 = std::min((float)image.height, y1 + margin);
+    if (x1 - x0 < 8.0f || y1 - y0 < 8.0f) return full;
+    return {x0, y0, x1 - x0, y1 - y0};
+  }
+
+  /**
+   * フレームを推論用の入力テンソルに変換（切り出し・レターボックス縮小・正規化を1パスで）
+   */
+  void preprocess(const CameraFrame &frame, PoseInputTensor &tensor) {
+    const ImageData &image = frame.image;
+    tensor.timestamp = frame.timestamp;
+    bool valid = image.width > 0 && image.height > 0 && image.channels >= 1 && image.channels <= 4 &&
+                 image.pixels.size() >= (size_t)image.width * image.height * image.channels;
+    if (!valid) {
+      // 画像が無い場合はテンソル座標とフレーム座標を一致させる
+      LetterboxTransform &t = tensor.transform;
+      t = LetterboxTransform();
+      t.tensorWidth = tensor.width;
+      t.tensorHeight = tensor.height;
+      t.sourceWidth = tensor.width;
+      t.sourceHeight = tensor.height;
+      return;
+    }
+    resampler.run(image, regionOfInterest(image), tensor);
+  }
+
+  /**
+   * キーフレームを推定器に投入（前の入力バッファの読み出し完了を待つことがある）
+   */
+  void submitInference(const CameraFrame &frame) {
+    PoseInputTensor &input = estimator->acquireInput();
+    preprocess(frame, input);
+    pendingTransform = input.transform;
+    pendingTicket = estimator->submit();
+    pendingFrameIndex = frameIndex;
+    pendingTimestamp = frame.timestamp;
+    hasPending = true;
+  }
+
+  /**
+   * 投入済みの推論結果を回収してトラックを更新
+   * @param block 完了まで待つか
+   */
+  bool collectInference(bool block) {
+    if (!hasPending) return false;
+    bool ready = block ? estimator->wait(pendingTicket, detections)
+                       : estimator->poll(pendingTicket, detections);
+    if (!ready && !block) return false;
+    hasPending = false;
+    if (!ready) return false;
+
+    // テンソル座標からフレームの正規化座標へ戻す
+    for (auto &pose : detections) {
+      for (auto &landmark : pose.landmarks) landmark = pendingTransform.tensorToFrame(landmark);
+    }
+    associateDetections(detections, pendingTimestamp, pendingFrameIndex);
+    return true;
+  }
+
+  /**
+   * 追跡中の姿勢と検出の距離（双方で見えているランドマークの平均距離）
+   */
+  float poseDistance(const BodyPose &a, const BodyPose &b) {
+    float sum = 0.0f;
+    int count = 0;
+    for (int i = 0; i < MEDIA_PIPE_LANDMARKS; ++i) {
+      if (a.visibility[i] < 0.5f || b.visibility[i] < 0.5f) continue;
+      sum += distance(a.landmarks[i], b.landmarks[i]);
+      ++count;
+    }
+    return count > 0 ? sum / count : std::numeric_limits<float>::max();
+  }
+
+  /**
+   * 検出を既存トラックにハンガリアン法で対応付け、トラックを更新・生成・破棄
+   */
+  void associateDetections(const std::vector<BodyPose> &poses, float timestamp,
+                           uint64_t sourceFrame) {
+    int numTracks = (int)tracks.size(), numDetections = (int)poses.size();
+    std::vector<int> trackForDetection(numDetections, -1);
+
+    if (numTracks > 0 && numDetections > 0) {
+      // 行数 <= 列数 になるよう向きを選ぶ
+      bool tracksAsRows = numTracks <= numDetections;
+      int rows = tracksAsRows ? numTracks : numDetections;
+      int cols = tracksAsRows ? numDetections : numTracks;
+      std::vector<float> cost((size_t)rows * cols);
+      for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+          int t = tracksAsRows ? r : c, d = tracksAsRows ? c : r;
+          cost[(size_t)r * cols + c] = std::min(poseDistance(tracks[t].pose, poses[d]), 1e6f);
+        }
+      }
+      std::vector<int> assignment = solveAssignment(cost, rows, cols);
+      for (int r = 0; r < rows; ++r) {
+        int c = assignment[r];
+        if (c < 0 || cost[(size_t)r * cols + c] > config.maxAssociationDistance) continue;
+        int t = tracksAsRows ? r : c, d = tracksAsRows ? c : r;
+        trackForDetection[d] = t;
+      }
+    }
+
+    std::vector<bool> matched(numTracks, false);
+    for (int d = 0; d < numDetections; ++d) {
+      int t = trackForDetection[d];
+      if (t < 0) continue;
+      matched[t] = true;
+
+      recordKeyframe(tracks[t], poses[d], timestamp, sourceFrame);
+    }
+
+    // 見失ったトラックは外挿を続け、一定回数で破棄
+    for (int t = 0; t < numTracks; ++t) {
+      if (!matched[t]) ++tracks[t].missedKeyframes;
+    }
+    tracks.erase(std::remove_if(tracks.begin(), tracks.end(),
+                                [&](const PersonTrack &track) {
+                                  return track.missedKeyframes > config.maxMissedKeyframes;
+                                }),
+                 tracks.end());
+
+    // 対応の無い検出は新しいトラックとして追加（numPoses人まで）
+    for (int d = 0; d < numDetections; ++d) {
+      if (trackForDetection[d] >= 0 || (int)tracks.size() >= std::max(config.numPoses, 1)) continue;
+      PersonTrack track;
+      track.id = nextTrackId++;
+      recordKeyframe(track, poses[d], timestamp, sourceFrame);
+      tracks.push_back(std::move(track));
+    }
+  }
+
+  /**
+   * 追跡中の人物の骨格をカプセルとして縮小解像度のマスクに描画
+   *
+   * 半径は胴の長さに比例させ、境界は1マスク画素幅で柔らかくする。
+   * 各カプセルは外接矩形内の画素のみ走査する。
+   */
+  void rasterizeSegmentation(const ImageData &image, SegmentationMask &mask) {
+    int downscale = std::max(config.segmentationDownscale, 1);
+    int w = (image.width + downscale - 1) / downscale;
+    int h = (image.height + downscale - 1) / downscale;
+    mask.allocate(w, h, config.segmentationFormat, image.width, image.height);
+
+    for (const auto &track : tracks) {
+      const BodyPose &pose = track.pose;
+      // 正規化座標 [-1, 1] → マスク画素
+      auto toMask = [&](int index) {
+        const Point3D &p = pose.landmarks[index];
+        return Point2D{(p.x + 1.0f) * 0.5f * w, (p.y + 1.0f) * 0.5f * h};
+      };
+      auto midpoint = [](const Point2D &p, const Point2D &q) {
+        return Point2D{(p.x + q.x) * 0.5f, (p.y + q.y) * 0.5f};
+      };
+      Point2D shoulder = midpoint(toMask(11), toMask(12));
+      Point2D hip = midpoint(toMask(23), toMask(24));
+      float torso = std::hypot(shoulder.x - hip.x, shoulder.y - hip.y);
+      if (torso < 1e-3f) continue;
+
+      // 胴体の中心線は肩幅の半分、手足は細め、頭部（鼻のみ）は円
+      drawCapsule(mask, shoulder, hip, torso * 0.35f);
+      for (const auto &[a, b] : SEGMENT_BONES) {
+        if (pose.visibility[a] < config.minTrackingConfidence ||
+            pose.visibility[b] < config.minTrackingConfidence) {
+          continue;
+        }
+        drawCapsule(mask, toMask(a), toMask(b), torso * (a == b ? 0.25f : 0.12f));
+      }
+    }
+  }
+
+  static void drawCapsule(SegmentationMask &mask, const Point2D &a, const Point2D &b, float radius) {
+    int x0 = std::max(0, (int)std::floor(std::min(a.x, b.x) - radius - 1.0f));
+    int x1 = std::min(mask.width - 1, (int)std::ceil(std::max(a.x, b.x) + radius + 1.0f));
+    int y0 = std::max(0, (int)std::floor(std::min(a.y, b.y) - radius - 1.0f));
+    int y1 = std::min(mask.height - 1, (int)std::ceil(std::max(a.y, b.y) + radius + 1.0f));
+
+    Point2D ab{b.x - a.x, b.y - a.y};
+    float lengthSq = ab.x * ab.x + ab.y * ab.y;
+    for (int y = y0; y <= y1; ++y) {
+      for (int x = x0; x <= x1; ++x) {
+        // 画素中心から線分までの距離
+        Point2D ap{x + 0.5f - a.x, y + 0.5f - a.y};
+        float t = lengthSq > 0.0f ? std::clamp((ap.x * ab.x + ap.y * ab.y) / lengthSq, 0.0f, 1.0f) : 0.0f;
+        float d = std::hypot(ap.x - ab.x * t, ap.y - ab.y * t);
+        float coverage = std::clamp(radius - d + 0.5f, 0.0f, 1.0f);
+        uint8_t value = (uint8_t)std::lround(coverage * 255.0f);
+        if (value > mask.at(x, y)) mask.set(x, y, value);
+      }
+    }
+  }
+
+  /**
+   * フィッティングに使うランドマーク（ボーン端点）のいずれかが前回のフィット時から
+   * 閾値を超えて動いたか
+   */
+  bool poseMoved(const PersonTrack &track) const {
+    float threshold = config.poseDeltaThreshold;
+    if (threshold <= 0.0f) return true;
+    for (const auto &[landmark, joint] : FIT_LANDMARK_JOINTS) {
+      const Point3D &a = track.pose.landmarks[landmark], &b = track.fittedLandmarks[landmark];
+      if (std::abs(a.x - b.x) > threshold || std::abs(a.y - b.y) > threshold ||
+          std::abs(a.z - b.z) > threshold) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * 肩と腰の中央間の距離から全体スケールを推定
+   */
+  float estimateScale(const BodyPose &pose) {
+    Point3D hipCenter = (pose.getLandmark(BodyLandmark::LEFT_HIP) +
+                         pose.getLandmark(BodyLandmark::RIGHT_HIP)) * 0.5f;
+    Point3D shoulderCenter = (pose.getLandmark(BodyLandmark::LEFT_SHOULDER) +
+                              pose.getLandmark(BodyLandmark::RIGHT_SHOULDER)) * 0.5f;
+    float torsoLength = distance(shoulderCenter, hipCenter);
+    float standardTorso = 0.6f;
+    float scale = torsoLength / standardTorso;
+    return scale < 0.01f ? 1.0f : scale;
+  }
+
+  float distance(const Point3D &a, const Point3D &b) const {
+    float dx = a.x - b.x;
+    float dy = a.y - b.y;
+    float dz = a.z - b.z;
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
   }
 };
 
@@ -66,6 +1158,21 @@ BodyTracker::~BodyTracker() = default;
 
 Result<void> BodyTracker::initialize(const BodyTrackerConfig &config) {
   pImpl->config = config;
+  if (!pImpl->estimator) {
+    PoseEstimatorConfig estimatorConfig;
+    estimatorConfig.maxPoses = std::max(config.numPoses, 1);
+    pImpl->estimator = std::make_shared<ReferencePoseEstimator>(estimatorConfig);
+  }
+
+  // SMPLモデルファイルが指定されていればメモリマップで読み込む
+  if (!config.smplModelPath.empty()) {
+    auto model = SMPLModel::load(config.smplModelPath);
+    if (!model) {
+      return {.error = model.error, .message = model.message};
+    }
+    pImpl->setModel(model.value);
+  }
+
   pImpl->initialized = true;
   return {.error = ErrorCode::SUCCESS};
 }
@@ -74,71 +1181,106 @@ Result<void> BodyTracker::initialize(const BodyTrackerConfig &config) {
  * フレームを処理してボディトラッキング結果を返す
  */
 Result<BodyTrackingResult> BodyTracker::processFrame(const CameraFrame &frame) {
+  BodyTrackingResult result;
+  auto status = processFrame(frame, result);
+  if (!status) {
+    return {.error = status.error, .message = status.message};
+  }
+  return {.value = std::move(result), .error = ErrorCode::SUCCESS};
+}
+
+Result<void> BodyTracker::processFrame(const CameraFrame &frame,
+                                       BodyTrackingResult &result) {
   if (!pImpl->initialized) {
     return {.error = ErrorCode::INITIALIZATION_FAILED,
             .message = "Body tracker not initialized"};
   }
 
-  BodyTrackingResult result;
   auto startTime = std::chrono::steady_clock::now();
 
-  // 画像の前処理（RGBAからRGBへ変換）
-  cv::Mat cvImage(frame.image.height, frame.image.width, CV_8UC4,
-                  const_cast<uint8_t *>(frame.image.pixels.data()));
-  cv::Mat rgbImage;
-  if (frame.image.channels == 4) {
-    cv::cvtColor(cvImage, rgbImage, cv::COLOR_RGBA2RGB);
+  // 推論はキーフレームのみ。パイプライン時は前回投入分を回収してから次を投入し、
+  // 推論と以降の処理（フィッティング・スキニング）を重ねる
+  result.isKeyframe = pImpl->isKeyframe(frame);
+  if (pImpl->config.pipelinedInference) {
+    pImpl->collectInference(result.isKeyframe);
+  }
+  if (result.isKeyframe) {
+    pImpl->submitInference(frame);
+    pImpl->framesSinceKeyframe = 0;
+    ++pImpl->numKeyframes;
+    pImpl->keyThumbnail.swap(pImpl->currentThumbnail);
+    // 非パイプライン時、または追跡対象がまだ無い場合はこのフレームの結果を待つ
+    if (!pImpl->config.pipelinedInference || pImpl->tracks.empty()) pImpl->collectInference(true);
   } else {
-    rgbImage = cvImage;
+    ++pImpl->framesSinceKeyframe;
   }
 
-  // ※ 実機では ARKit(iOS) / ARCore(Android) / MediaPipe からの
-  //   スケルトンデータを直接受け取るため、TFLite推論は不要。
-  //   ここではデモ用にシミュレーションデータを生成する。
+  // このフレームの検出が無いトラックは等速外挿
+  for (auto &track : pImpl->tracks) {
+    if (track.keyFrameIndex != pImpl->frameIndex) pImpl->extrapolatePose(track, frame.timestamp);
+  }
+
+  // 人物ごとのSMPLフィッティングとボディメッシュ生成を並列に実行
+  // （前フレームのバッファを再利用）
+  auto &tracks = pImpl->tracks;
+  int previousPrimary = result.people.empty() ? -1 : result.people.front().trackId;
+  result.people.resize(tracks.size());
+  ThreadPool::shared().parallelFor(0, tracks.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      PersonTrack &track = tracks[i];
+      TrackedPerson &person = result.people[i];
+      // 速度適応スムージング（静止時はジッターを抑え、速い動きには遅れず追従）
+      if (pImpl->config.smoothLandmarks) {
+        OneEuroParams params{pImpl->config.smoothingMinCutoff, pImpl->config.smoothingBeta};
+        track.filter.apply(track.pose.landmarks, frame.timestamp, params);
+      }
 
-  float time = std::chrono::duration<float>(startTime.time_since_epoch()).count();
-  float sway = std::sin(time * 2.0f) * 0.05f;
+      // このバッファが前フレームに同じ人物のメッシュを保持していれば差分更新できる
+      bool sameBuffer = person.trackId == track.id && person.bodyMesh.size() == (size_t)SMPL_NUM_VERTICES;
+      person.trackId = track.id;
+      person.pose = track.pose;
 
-  // 主要ランドマークの配置（正規化座標: 画面の中央が原点）
-  result.pose.landmarks[0]  = {0.0f + sway, -0.8f, 0.0f};    // NOSE
-  result.pose.landmarks[11] = {-0.2f + sway, -0.5f, 0.0f};   // LEFT_SHOULDER
-  result.pose.landmarks[12] = {0.2f + sway, -0.5f, 0.0f};    // RIGHT_SHOULDER
-  result.pose.landmarks[13] = {-0.35f + sway, -0.2f, 0.05f}; // LEFT_ELBOW
-  result.pose.landmarks[14] = {0.35f + sway, -0.2f, 0.05f};  // RIGHT_ELBOW
-  result.pose.landmarks[15] = {-0.4f, 0.0f, 0.1f};           // LEFT_WRIST
-  result.pose.landmarks[16] = {0.4f, 0.0f, 0.1f};            // RIGHT_WRIST
-  result.pose.landmarks[23] = {-0.12f, 0.1f, 0.0f};          // LEFT_HIP
-  result.pose.landmarks[24] = {0.12f, 0.1f, 0.0f};           // RIGHT_HIP
-  result.pose.landmarks[25] = {-0.15f, 0.5f, 0.0f};          // LEFT_KNEE
-  result.pose.landmarks[26] = {0.15f, 0.5f, 0.0f};           // RIGHT_KNEE
+      // ほぼ静止していればフィッティングとスキニングを省略
+      if (sameBuffer && track.hasFit && !pImpl->poseMoved(track)) {
+        person.smplParams = track.fitParams;
+        person.meshChanged = false;
+        continue;
+      }
+      person.smplParams = track.hasFit ? fitSMPL(track.pose, track.fitParams) : fitSMPL(track.pose);
+      track.fitParams = person.smplParams;
+      track.fittedLandmarks = track.pose.landmarks;
+      track.hasFit = true;
+      pImpl->forwardSMPL(track.workspace, person.smplParams, person.bodyMesh, sameBuffer);
+      person.meshChanged = true;
+    }
+  });
 
-  // 信頼度の設定
-  for (int i = 0; i < MEDIA_PIPE_LANDMARKS; ++i) {
-    result.pose.visibility[i] = 0.95f;
+  // 先頭の人物を従来の単一人物フィールドにも反映
+  if (!result.people.empty()) {
+    const TrackedPerson &primary = result.people.front();
+    result.pose = primary.pose;
+    result.smplParams = primary.smplParams;
+    result.bodyMeshChanged = primary.meshChanged || primary.trackId != previousPrimary ||
+                             result.bodyMesh.size() != primary.bodyMesh.size();
+    if (result.bodyMeshChanged) result.bodyMesh.assign(primary.bodyMesh.begin(), primary.bodyMesh.end());
+    if (pImpl->poseLatch) pImpl->poseLatch->publish(primary.pose, frame.timestamp);
   }
-  result.pose.confidence = 0.98f;
 
-  // スムージング適用（前フレームとの補間でジッターを軽減）
-  if (pImpl->hasPrevFrame) {
-    for (int i = 0; i < MEDIA_PIPE_LANDMARKS; ++i) {
-      result.pose.landmarks[i] = pImpl->smoothLandmark(
-          result.pose.landmarks[i], pImpl->prevLandmarks[i]);
+  // 人物マスク（縮小解像度、必要ならランレングス表現も）
+  if (pImpl->config.enableSegmentation && frame.image.width > 0 && frame.image.height > 0) {
+    pImpl->rasterizeSegmentation(frame.image, result.segmentationMask);
+    if (pImpl->config.segmentationRunLength) {
+      encodeRunLength(result.segmentationMask, result.segmentationRuns);
     }
   }
-  pImpl->prevLandmarks = result.pose.landmarks;
-  pImpl->hasPrevFrame = true;
 
-  // SMPLパラメータの推定
-  result.smplParams = fitSMPL(result.pose);
-
-  // ボディメッシュの生成
-  result.bodyMesh = getSMPLMesh(result.smplParams);
+  ++pImpl->frameIndex;
 
   auto endTime = std::chrono::steady_clock::now();
   result.processingTimeMs =
       std::chrono::duration<float, std::milli>(endTime - startTime).count();
 
-  return {.value = result, .error = ErrorCode::SUCCESS};
+  return {.error = ErrorCode::SUCCESS};
 }
 
 BodyPose BodyTracker::estimate3DPose(const std::array<Point2D, 33> &landmarks2D,
@@ -162,34 +1304,58 @@ SMPLParams BodyTracker::fitSMPL(const BodyPose &pose) {
   params.shape.fill(0.0f);
   params.translation = {0.0f, 0.0f, 0.0f};
 
-  // 腰の中央を基準にトランスレーション推定
-  Point3D hipCenter = (pose.getLandmark(BodyLandmark::LEFT_HIP) +
-                       pose.getLandmark(BodyLandmark::RIGHT_HIP)) * 0.5f;
-  params.translation = hipCenter;
+  // 腰の中央を基準にトランスレーション推定（モデル座標系、y上向き）
+  Point3D hipCenter = landmarkToModel((pose.getLandmark(BodyLandmark::LEFT_HIP) +
+                                       pose.getLandmark(BodyLandmark::RIGHT_HIP)) * 0.5f);
+  params.translation = {hipCenter.x, hipCenter.y, hipCenter.z};
+  params.scale = pImpl->estimateScale(pose);
 
-  // 肩の中央を計算してスケール推定
-  Point3D shoulderCenter = (pose.getLandmark(BodyLandmark::LEFT_SHOULDER) +
-                            pose.getLandmark(BodyLandmark::RIGHT_SHOULDER)) * 0.5f;
-  float torsoLength = pImpl->distance(shoulderCenter, hipCenter);
-  float standardTorso = 0.6f;
-  params.scale = torsoLength / standardTorso;
-  if (params.scale < 0.01f) params.scale = 1.0f;
+  // 初期値からポーズ・形状を反復推定
+  pImpl->refineSMPL(pose, params);
+  return params;
+}
 
+SMPLParams BodyTracker::fitSMPL(const BodyPose &pose, const SMPLParams &initial) {
+  SMPLParams params = initial;
+  params.scale = pImpl->estimateScale(pose);
+  pImpl->refineSMPL(pose, params);
   return params;
 }
 
 std::vector<Point3D> BodyTracker::getSMPLMesh(const SMPLParams &params) {
-  std::vector<Point3D> mesh = pImpl->smplTemplate;
-  for (auto &v : mesh) {
-    v = v * params.scale + params.translation;
-  }
+  std::vector<Point3D> mesh;
+  getSMPLMesh(params, mesh);
   return mesh;
 }
 
+void BodyTracker::getSMPLMesh(const SMPLParams &params,
+                              std::vector<Point3D> &vertices) {
+  std::lock_guard<std::mutex> lock(pImpl->workspaceMutex);
+  pImpl->forwardSMPL(pImpl->workspace, params, vertices);
+}
+
 bool BodyTracker::isInitialized() const { return pImpl->initialized; }
 void BodyTracker::reset() { 
   pImpl->initialized = false; 
-  pImpl->hasPrevFrame = false;
+  pImpl->tracks.clear();
+  pImpl->numKeyframes = 0;
+  pImpl->framesSinceKeyframe = 0;
+  if (pImpl->hasPending) {
+    std::vector<BodyPose> discarded;
+    pImpl->estimator->wait(pImpl->pendingTicket, discarded);
+    pImpl->hasPending = false;
+  }
 }
 
+void BodyTracker::setPoseEstimator(std::shared_ptr<IPoseEstimator> estimator) {
+  if (pImpl->hasPending) {
+    std::vector<BodyPose> discarded;
+    pImpl->estimator->wait(pImpl->pendingTicket, discarded);
+    pImpl->hasPending = false;
+  }
+  pImpl->estimator = std::move(estimator);
+}
+
+void BodyTracker::setPoseLatch(std::shared_ptr<PoseLatch> latch) { pImpl->poseLatch = std::move(latch); }
+
 } // namespace arfit
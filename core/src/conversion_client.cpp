@@ -0,0 +1,567 @@
+/**
+ * @file conversion_client.cpp
+ * @brief サーバー変換クライアント実装
+ *
+ * 固定数のワーカーがそれぞれ1本のkeep-alive接続を持ち、キューから要求を
+ * 取り出して処理します。同じURLへの同時要求は1件にまとめ、応答本文は
+ * 受信したそばからGarmentBlobDecoderへ流し込みます。
+ */
+
+#include "conversion_client.h"
+#include "garment_blob.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace arfit {
+
+namespace {
+
+using GarmentResult = Result<std::shared_ptr<Garment>>;
+
+constexpr size_t MAX_HEADER_SIZE = 16 * 1024;
+constexpr size_t RECV_BUFFER_SIZE = 64 * 1024;
+
+GarmentResult networkError(const std::string &message) {
+  return {.error = ErrorCode::NETWORK_ERROR, .message = message};
+}
+
+struct Endpoint {
+  std::string host;
+  std::string port = "80";
+  std::string path; // 末尾の"/"を除いたベースパス
+};
+
+bool parseEndpoint(const std::string &url, Endpoint &endpoint) {
+  const std::string scheme = "http://";
+  if (url.compare(0, scheme.size(), scheme) != 0) return false;
+
+  size_t hostBegin = scheme.size();
+  size_t pathBegin = url.find('/', hostBegin);
+  std::string authority = url.substr(hostBegin, pathBegin == std::string::npos ? std::string::npos
+                                                                               : pathBegin - hostBegin);
+  endpoint.path = pathBegin == std::string::npos ? "" : url.substr(pathBegin);
+  while (!endpoint.path.empty() && endpoint.path.back() == '/') endpoint.path.pop_back();
+
+  size_t colon = authority.rfind(':');
+  if (colon != std::string::npos && authority.find(']') == std::string::npos) {
+    endpoint.port = authority.substr(colon + 1);
+    authority.resize(colon);
+  }
+  if (authority.size() >= 2 && authority.front() == '[' && authority.back() == ']') {
+    authority = authority.substr(1, authority.size() - 2);
+  }
+  endpoint.host = authority;
+  return !endpoint.host.empty() && !endpoint.port.empty();
+}
+
+std::string percentEncode(const std::string &value) {
+  static const char HEX[] = "0123456789ABCDEF";
+  std::string out;
+  out.reserve(value.size() * 3);
+  for (unsigned char c : value) {
+    if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+      out += static_cast<char>(c);
+    } else {
+      out += '%';
+      out += HEX[c >> 4];
+      out += HEX[c & 15];
+    }
+  }
+  return out;
+}
+
+bool equalsIgnoreCase(const std::string &a, const char *b) {
+  size_t n = std::strlen(b);
+  if (a.size() != n) return false;
+  for (size_t i = 0; i < n; ++i) {
+    if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string trim(const std::string &s) {
+  size_t b = s.find_first_not_of(" \t");
+  if (b == std::string::npos) return "";
+  size_t e = s.find_last_not_of(" \t\r");
+  return s.substr(b, e - b + 1);
+}
+
+#if !defined(_WIN32)
+
+/**
+ * keep-alive接続1本分（ソケットと未処理の受信データ）
+ */
+class Connection {
+public:
+  ~Connection() { close(); }
+
+  bool isOpen() const { return fd >= 0; }
+
+  bool open(const Endpoint &endpoint, int timeoutMs) {
+    close();
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    if (getaddrinfo(endpoint.host.c_str(), endpoint.port.c_str(), &hints, &addresses) != 0) return false;
+
+    timeval tv{};
+    tv.tv_sec = timeoutMs / 1000;
+    tv.tv_usec = (timeoutMs % 1000) * 1000;
+    int connected = -1;
+    for (addrinfo *a = addresses; a && connected < 0; a = a->ai_next) {
+      int s = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+      if (s < 0) continue;
+      int one = 1;
+      setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+      setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+      setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+      setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+      if (::connect(s, a->ai_addr, a->ai_addrlen) == 0) {
+        connected = s;
+      } else {
+        ::close(s);
+      }
+    }
+    freeaddrinfo(addresses);
+    pending.clear();
+
+    std::lock_guard<std::mutex> lock(fdMutex);
+    fd = connected;
+    return fd >= 0;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(fdMutex);
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    pending.clear();
+  }
+
+  // 他スレッドからの中断用（ブロック中のrecvを即座に戻す）
+  void abort() {
+    std::lock_guard<std::mutex> lock(fdMutex);
+    if (fd >= 0) ::shutdown(fd, SHUT_RDWR);
+  }
+
+  bool sendAll(const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+#ifdef MSG_NOSIGNAL
+      ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+#else
+      ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+#endif
+      if (n <= 0) return false;
+      sent += static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  /**
+   * 次の受信データを返す（先読み分があればそれを優先）。0は切断かエラー
+   */
+  size_t receive(uint8_t *buffer, size_t capacity) {
+    if (!pending.empty()) {
+      size_t n = std::min(capacity, pending.size());
+      std::memcpy(buffer, pending.data(), n);
+      pending.erase(pending.begin(), pending.begin() + n);
+      return n;
+    }
+    ssize_t n = ::recv(fd, buffer, capacity, 0);
+    return n > 0 ? static_cast<size_t>(n) : 0;
+  }
+
+  // 読みすぎたデータを次のreceive()へ戻す
+  void unread(const uint8_t *data, size_t size) { pending.insert(pending.begin(), data, data + size); }
+
+  /**
+   * CRLFまでの1行を読む（チャンクサイズ行・トレーラー用）
+   */
+  bool readLine(std::string &line) {
+    line.clear();
+    for (;;) {
+      auto newline = std::find(pending.begin(), pending.end(), '\n');
+      if (newline != pending.end()) {
+        line.assign(pending.begin(), newline);
+        pending.erase(pending.begin(), newline + 1);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        return true;
+      }
+      if (pending.size() > MAX_HEADER_SIZE) return false;
+      uint8_t buffer[4096];
+      ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0) return false;
+      pending.insert(pending.end(), buffer, buffer + n);
+    }
+  }
+
+  // fdの書き換えはワーカーのみ。abort()からの参照とはfdMutexで排他する
+  int fd = -1;
+
+private:
+  std::mutex fdMutex;
+  std::vector<uint8_t> pending;
+};
+
+/**
+ * 応答本文を受信しながらsinkへ渡す。Content-Length・chunked・切断終端に対応
+ */
+class ResponseReader {
+public:
+  int status = 0;
+  bool keepAlive = false;
+  bool receivedAny = false; // 応答の1バイト目を受け取ったか（再送可否の判定用）
+
+  template <typename Sink>
+  bool read(Connection &conn, Sink &&sink, std::string &error) {
+    if (!readHeaders(conn, error)) return false;
+    if (chunked) return readChunked(conn, sink, error);
+    if (hasLength) return readLength(conn, contentLength, sink, error);
+
+    // 長さ不明：切断までが本文
+    keepAlive = false;
+    size_t n;
+    while ((n = conn.receive(buffer, sizeof(buffer))) > 0) {
+      if (!sink(buffer, n)) return false;
+    }
+    return true;
+  }
+
+private:
+  uint8_t buffer[RECV_BUFFER_SIZE];
+  bool chunked = false;
+  bool hasLength = false;
+  uint64_t contentLength = 0;
+
+  bool readHeaders(Connection &conn, std::string &error) {
+    std::string head;
+    size_t headerEnd;
+    for (;;) {
+      size_t n = conn.receive(buffer, sizeof(buffer));
+      if (n == 0) {
+        error = receivedAny ? "Connection closed in response headers" : "Connection closed";
+        return false;
+      }
+      receivedAny = true;
+      size_t searchFrom = head.size() >= 3 ? head.size() - 3 : 0;
+      head.append(reinterpret_cast<const char *>(buffer), n);
+      headerEnd = head.find("\r\n\r\n", searchFrom);
+      if (headerEnd != std::string::npos) break;
+      if (head.size() > MAX_HEADER_SIZE) {
+        error = "Response headers too large";
+        return false;
+      }
+    }
+    size_t bodyStart = headerEnd + 4;
+    if (bodyStart < head.size()) {
+      conn.unread(reinterpret_cast<const uint8_t *>(head.data()) + bodyStart, head.size() - bodyStart);
+    }
+    head.resize(headerEnd);
+
+    // ステータス行 "HTTP/1.x NNN reason"
+    size_t lineEnd = head.find("\r\n");
+    std::string statusLine = head.substr(0, lineEnd);
+    if (statusLine.compare(0, 5, "HTTP/") != 0 || statusLine.size() < 12) {
+      error = "Malformed response";
+      return false;
+    }
+    keepAlive = statusLine.compare(0, 8, "HTTP/1.1") == 0;
+    status = std::atoi(statusLine.c_str() + 9);
+
+    while (lineEnd != std::string::npos) {
+      size_t next = head.find("\r\n", lineEnd + 2);
+      std::string line = head.substr(lineEnd + 2, next == std::string::npos ? std::string::npos : next - lineEnd - 2);
+      lineEnd = next;
+      size_t colon = line.find(':');
+      if (colon == std::string::npos) continue;
+      std::string name = trim(line.substr(0, colon));
+      std::string value = trim(line.substr(colon + 1));
+      if (equalsIgnoreCase(name, "content-length")) {
+        hasLength = true;
+        contentLength = std::strtoull(value.c_str(), nullptr, 10);
+      } else if (equalsIgnoreCase(name, "transfer-encoding")) {
+        chunked = value.find("chunked") != std::string::npos;
+      } else if (equalsIgnoreCase(name, "connection")) {
+        if (equalsIgnoreCase(value, "close")) keepAlive = false;
+        if (equalsIgnoreCase(value, "keep-alive")) keepAlive = true;
+      }
+    }
+    return true;
+  }
+
+  template <typename Sink>
+  bool readLength(Connection &conn, uint64_t remaining, Sink &sink, std::string &error) {
+    while (remaining > 0) {
+      size_t n = conn.receive(buffer, static_cast<size_t>(std::min<uint64_t>(remaining, sizeof(buffer))));
+      if (n == 0) {
+        error = "Connection closed in response body";
+        return false;
+      }
+      remaining -= n;
+      if (!sink(buffer, n)) return false;
+    }
+    return true;
+  }
+
+  bool readLine(Connection &conn, std::string &line, std::string &error) {
+    if (conn.readLine(line)) return true;
+    error = "Malformed chunked response";
+    return false;
+  }
+
+  template <typename Sink>
+  bool readChunked(Connection &conn, Sink &sink, std::string &error) {
+    std::string line;
+    for (;;) {
+      if (!readLine(conn, line, error)) return false;
+      uint64_t size = std::strtoull(line.c_str(), nullptr, 16); // ";ext"は無視
+      if (size == 0) break;
+      if (!readLength(conn, size, sink, error)) return false;
+      if (!readLine(conn, line, error)) return false; // チャンク末尾のCRLF
+    }
+    // トレーラーを空行まで読み捨てる
+    do {
+      if (!readLine(conn, line, error)) return false;
+    } while (!line.empty());
+    return true;
+  }
+};
+
+#endif
+
+} // namespace
+
+class ConversionClient::Impl {
+public:
+  // 同じURLの要求を束ねた1件分
+  struct Request {
+    std::string imageUrl;
+    std::vector<ConversionCallback> callbacks;
+  };
+
+  ConversionClientConfig config;
+  Endpoint endpoint;
+  bool endpointValid = false;
+
+  mutable std::mutex mutex;
+  std::condition_variable queueReady;
+  std::deque<std::shared_ptr<Request>> queue;
+  std::unordered_map<std::string, std::shared_ptr<Request>> pending; // キュー待ち・処理中の要求
+  bool stopping = false;
+  ConversionClientStats stats;
+
+#if !defined(_WIN32)
+  std::vector<std::unique_ptr<Connection>> connections; // ワーカーごと
+#endif
+  std::vector<std::thread> workers;
+
+  void start() {
+#if !defined(_WIN32)
+    int count = std::max(1, config.maxConnections);
+    for (int i = 0; i < count; ++i) connections.push_back(std::make_unique<Connection>());
+    for (int i = 0; i < count; ++i) workers.emplace_back([this, i] { run(*connections[i]); });
+#endif
+  }
+
+  void stop() {
+    std::deque<std::shared_ptr<Request>> cancelled;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+      cancelled.swap(queue);
+      for (auto &request : cancelled) pending.erase(request->imageUrl);
+#if !defined(_WIN32)
+      for (auto &conn : connections) conn->abort();
+#endif
+    }
+    queueReady.notify_all();
+    for (auto &worker : workers) worker.join();
+
+    for (auto &request : cancelled) {
+      complete(*request, networkError("Conversion client stopped"));
+    }
+  }
+
+  static void complete(const Request &request, const GarmentResult &result) {
+    for (auto &callback : request.callbacks) callback(result);
+  }
+
+#if !defined(_WIN32)
+  void run(Connection &conn) {
+    for (;;) {
+      std::shared_ptr<Request> request;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        queueReady.wait(lock, [&] { return stopping || !queue.empty(); });
+        if (stopping) break;
+        request = queue.front();
+        queue.pop_front();
+      }
+
+      GarmentResult result = fetch(conn, request->imageUrl);
+
+      // 完了後に来た要求は新しい要求として扱われるよう、通知前に登録を外す
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.erase(request->imageUrl);
+      }
+      complete(*request, result);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    conn.close();
+  }
+
+  bool isStopping() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stopping;
+  }
+
+  bool connect(Connection &conn) {
+    if (isStopping()) return false;
+    if (!conn.open(endpoint, config.timeoutMs)) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++stats.connectionsOpened;
+    // 接続中に停止が始まっていた場合はここで中断させる
+    if (stopping) conn.abort();
+    return true;
+  }
+
+  GarmentResult fetch(Connection &conn, const std::string &imageUrl) {
+    std::string message = "GET " + endpoint.path + "/convert?url=" + percentEncode(imageUrl) +
+                          " HTTP/1.1\r\n"
+                          "Host: " + endpoint.host + ":" + endpoint.port + "\r\n"
+                          "Connection: keep-alive\r\n"
+                          "Accept: application/x-arfit-garment\r\n\r\n";
+
+    // 使い回した接続はサーバー側で閉じられている場合があるため、
+    // 応答を1バイトも受け取れなかったときだけ新しい接続で1回やり直す
+    for (int attempt = 0; attempt < 2; ++attempt) {
+      bool reused = conn.isOpen();
+      if (!reused && !connect(conn)) {
+        if (isStopping()) return networkError("Conversion client stopped");
+        return networkError("Cannot connect to " + endpoint.host + ":" + endpoint.port);
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++stats.serverRequests;
+      }
+
+      ResponseReader reader;
+      GarmentBlobDecoder decoder;
+      std::string error;
+      std::string errorBody;
+      bool ok = conn.sendAll(message) &&
+                reader.read(
+                    conn,
+                    [&](const uint8_t *data, size_t size) {
+                      if (reader.status != 200) {
+                        // エラー応答は先頭だけメッセージ用に残して読み捨てる
+                        errorBody.append(reinterpret_cast<const char *>(data),
+                                         std::min(size, 256 - std::min<size_t>(256, errorBody.size())));
+                        return true;
+                      }
+                      if (decoder.feed(data, size)) return true;
+                      error = decoder.error();
+                      return false;
+                    },
+                    error);
+
+      if (!ok) {
+        conn.close();
+        // 停止による中断は再試行しない
+        if (isStopping()) return networkError("Conversion client stopped");
+        if (reused && !reader.receivedAny) continue;
+        return networkError(error.empty() ? "Request failed" : error);
+      }
+      if (!reader.keepAlive) conn.close();
+
+      if (reader.status != 200) {
+        return networkError("Server returned " + std::to_string(reader.status) +
+                            (errorBody.empty() ? "" : ": " + trim(errorBody)));
+      }
+      auto garment = decoder.finish();
+      if (!garment) {
+        conn.close();
+        return networkError("Invalid garment data: " + decoder.error());
+      }
+      return {.value = garment, .error = ErrorCode::SUCCESS};
+    }
+    return networkError("Connection lost");
+  }
+#endif
+};
+
+ConversionClient::ConversionClient(const ConversionClientConfig &config) : pImpl(std::make_unique<Impl>()) {
+  pImpl->config = config;
+  pImpl->endpointValid = parseEndpoint(config.endpoint, pImpl->endpoint);
+  if (pImpl->endpointValid) pImpl->start();
+}
+
+ConversionClient::~ConversionClient() { pImpl->stop(); }
+
+void ConversionClient::convert(const std::string &imageUrl, ConversionCallback callback) {
+#if defined(_WIN32)
+  callback(networkError("Server processing is not supported on this platform"));
+#else
+  if (!pImpl->endpointValid) {
+    callback(networkError("Invalid server endpoint: " + pImpl->config.endpoint));
+    return;
+  }
+
+  std::string message = "Conversion queue is full";
+  {
+    std::lock_guard<std::mutex> lock(pImpl->mutex);
+    ++pImpl->stats.requests;
+    if (pImpl->stopping) {
+      message = "Conversion client stopped";
+    } else {
+      auto it = pImpl->pending.find(imageUrl);
+      if (it != pImpl->pending.end()) {
+        ++pImpl->stats.coalesced;
+        it->second->callbacks.push_back(std::move(callback));
+        return;
+      }
+      if (pImpl->queue.size() < static_cast<size_t>(std::max(0, pImpl->config.maxQueuedRequests))) {
+        auto request = std::make_shared<Impl::Request>();
+        request->imageUrl = imageUrl;
+        request->callbacks.push_back(std::move(callback));
+        pImpl->pending.emplace(imageUrl, request);
+        pImpl->queue.push_back(std::move(request));
+        pImpl->queueReady.notify_one();
+        return;
+      }
+    }
+  }
+  callback(networkError(message));
+#endif
+}
+
+ConversionClientStats ConversionClient::getStats() const {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  return pImpl->stats;
+}
+
+} // namespace arfit
@@ -0,0 +1,221 @@
+/**
+ * @file drape_cache.cpp
+ * @brief 体型別ドレープキャッシュの実装
+ *
+ * 標準体型上で事前に落ち着かせた衣服の粒子状態をディスクに保存し、
+ * 試着開始時の初期形状として再利用します。
+ */
+
+#include "drape_cache.h"
+#include "atomic_file.h"
+#include "garment_converter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+
+namespace arfit {
+
+namespace {
+
+constexpr uint32_t DRAPE_MAGIC = 0x52444641; // "AFDR"
+constexpr uint32_t DRAPE_VERSION = 1;
+
+/**
+ * ドレープファイルのヘッダー
+ */
+struct DrapeHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t garmentKey;
+  int8_t bucket[10];
+  uint16_t reserved;
+  uint32_t particleCount;
+};
+
+uint64_t fnv1a(uint64_t hash, const void *data, size_t size) {
+  const auto *bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+} // namespace
+
+class DrapeCache::Impl {
+public:
+  DrapeCacheConfig config;
+  bool initialized = false;
+
+  // 衣服キー -> 保存済みの体型バケット一覧
+  std::map<uint64_t, std::vector<ShapeBucket>> index;
+  mutable std::mutex mutex;
+
+  std::filesystem::path pathFor(uint64_t key, const ShapeBucket &bucket) const {
+    char name[64];
+    int len = std::snprintf(name, sizeof(name), "%016llx_",
+                            static_cast<unsigned long long>(key));
+    for (int8_t b : bucket) {
+      len += std::snprintf(name + len, sizeof(name) - len, "%02x",
+                           static_cast<uint8_t>(b));
+    }
+    return std::filesystem::path(config.directory) / (std::string(name) + ".drape");
+  }
+
+  /**
+   * ヘッダーのみ読み込んでインデックスに登録
+   */
+  void indexFile(const std::filesystem::path &path) {
+    std::ifstream in(path, std::ios::binary);
+    DrapeHeader header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) return;
+    if (header.magic != DRAPE_MAGIC || header.version != DRAPE_VERSION) return;
+
+    ShapeBucket bucket;
+    std::copy(std::begin(header.bucket), std::end(header.bucket), bucket.begin());
+    index[header.garmentKey].push_back(bucket);
+  }
+
+  bool load(uint64_t key, const ShapeBucket &bucket,
+            std::vector<Point3D> &positions) const {
+    std::ifstream in(pathFor(key, bucket), std::ios::binary);
+    DrapeHeader header;
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) return false;
+    if (header.magic != DRAPE_MAGIC || header.version != DRAPE_VERSION ||
+        header.garmentKey != key) {
+      return false;
+    }
+
+    positions.resize(header.particleCount);
+    return static_cast<bool>(
+        in.read(reinterpret_cast<char *>(positions.data()),
+                sizeof(Point3D) * positions.size()));
+  }
+};
+
+DrapeCache::DrapeCache() : pImpl(std::make_unique<Impl>()) {}
+DrapeCache::~DrapeCache() = default;
+
+Result<void> DrapeCache::initialize(const DrapeCacheConfig &config) {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  pImpl->config = config;
+  pImpl->index.clear();
+
+  std::error_code ec;
+  std::filesystem::create_directories(config.directory, ec);
+  if (ec) {
+    return {.error = ErrorCode::IO_ERROR,
+            .message = "Cannot create drape cache directory: " + ec.message()};
+  }
+
+  for (const auto &entry : std::filesystem::directory_iterator(config.directory, ec)) {
+    if (entry.path().extension() == ".drape") {
+      pImpl->indexFile(entry.path());
+    }
+  }
+
+  pImpl->initialized = true;
+  return {.error = ErrorCode::SUCCESS};
+}
+
+uint64_t DrapeCache::garmentKey(const Garment &garment) {
+  uint64_t hash = 14695981039346656037ull;
+  GarmentType type = garment.getType();
+  hash = fnv1a(hash, &type, sizeof(type));
+
+  auto mesh = garment.getMesh();
+  if (!mesh) return hash;
+
+  // 頂点座標はアニメーションで変化するため、面とUVのみをハッシュ化
+  const auto &faces = mesh->getFaces();
+  hash = fnv1a(hash, faces.data(), faces.size() * sizeof(Face));
+  for (const auto &v : mesh->getVertices()) {
+    hash = fnv1a(hash, &v.texCoord, sizeof(v.texCoord));
+  }
+  return hash;
+}
+
+ShapeBucket DrapeCache::quantize(const std::array<float, 10> &betas) const {
+  ShapeBucket bucket{};
+  int n = std::clamp(pImpl->config.numQuantizedBetas, 0, 10);
+  for (int i = 0; i < n; ++i) {
+    float q = std::round(betas[i] / pImpl->config.betaQuantization);
+    bucket[i] = static_cast<int8_t>(std::clamp(q, -127.0f, 127.0f));
+  }
+  return bucket;
+}
+
+bool DrapeCache::contains(uint64_t key, const ShapeBucket &bucket) const {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  auto it = pImpl->index.find(key);
+  if (it == pImpl->index.end()) return false;
+  return std::find(it->second.begin(), it->second.end(), bucket) != it->second.end();
+}
+
+bool DrapeCache::findNearest(uint64_t key, const std::array<float, 10> &betas,
+                             std::vector<Point3D> &positions) const {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  if (!pImpl->initialized) return false;
+
+  auto it = pImpl->index.find(key);
+  if (it == pImpl->index.end() || it->second.empty()) return false;
+
+  // 量子化前のベータ値とバケット中心の距離で最も近いものを選ぶ
+  const ShapeBucket *best = nullptr;
+  float bestDist = 0.0f;
+  for (const auto &bucket : it->second) {
+    float dist = 0.0f;
+    for (int i = 0; i < 10; ++i) {
+      float d = betas[i] - bucket[i] * pImpl->config.betaQuantization;
+      dist += d * d;
+    }
+    if (!best || dist < bestDist) {
+      best = &bucket;
+      bestDist = dist;
+    }
+  }
+  return pImpl->load(key, *best, positions);
+}
+
+Result<void> DrapeCache::store(uint64_t key, const ShapeBucket &bucket,
+                               const std::vector<Point3D> &positions) {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  if (!pImpl->initialized) {
+    return {.error = ErrorCode::INITIALIZATION_FAILED,
+            .message = "Drape cache not initialized"};
+  }
+
+  DrapeHeader header{};
+  header.magic = DRAPE_MAGIC;
+  header.version = DRAPE_VERSION;
+  header.garmentKey = key;
+  std::copy(bucket.begin(), bucket.end(), header.bucket);
+  header.particleCount = static_cast<uint32_t>(positions.size());
+
+  auto written = writeFileAtomically(pImpl->pathFor(key, bucket), [&](std::ofstream &out) -> Result<void> {
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(positions.data()),
+              sizeof(Point3D) * positions.size());
+    if (!out) return {.error = ErrorCode::IO_ERROR, .message = "Failed to write drape"};
+    return {.error = ErrorCode::SUCCESS};
+  });
+  if (!written) return written;
+
+  auto &buckets = pImpl->index[key];
+  if (std::find(buckets.begin(), buckets.end(), bucket) == buckets.end()) {
+    buckets.push_back(bucket);
+  }
+  return {.error = ErrorCode::SUCCESS};
+}
+
+bool DrapeCache::isInitialized() const {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  return pImpl->initialized;
+}
+
+} // namespace arfit
@@ -0,0 +1,378 @@
+/**
+ * @file garment_blob.h
+ * @brief Versioned binary encoding of a converted garment (internal)
+ *
+ * Shared by the on-disk garment cache and the hybrid conversion server
+ * protocol. Layout: a fixed header, a table of GARMENT_BLOB_SECTION_COUNT
+ * sections and the section payloads, each starting on a 64-byte boundary,
+ * in table order.
+ */
+
+#pragma once
+
+#include "garment_converter.h"
+#include "types.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace arfit {
+
+constexpr char GARMENT_BLOB_MAGIC[8] = {'A', 'R', 'F', 'G', 'A', 'R', 'M', '\0'};
+constexpr uint32_t GARMENT_BLOB_VERSION = 1;
+constexpr uint32_t GARMENT_BLOB_ALIGNMENT = 64;
+
+/**
+ * @brief Section indices of a garment blob
+ */
+enum GarmentBlobSectionId : uint32_t {
+  GARMENT_SECTION_VERTICES = 0,  // Vertex [vertexCount]
+  GARMENT_SECTION_FACES,         // Face [faceCount]
+  GARMENT_SECTION_UV_COORDS,     // Point2D [uvCount]
+  GARMENT_SECTION_WEIGHT_ROWS,   // uint32 [weightRowCount + 1] (CSR row starts)
+  GARMENT_SECTION_BONE_WEIGHTS,  // Garment::BoneWeight [boneWeightCount]
+  GARMENT_SECTION_CONSTRAINTS,   // Garment::SpringConstraint [constraintCount]
+  GARMENT_SECTION_TEXTURE,       // uint8 [textureWidth * textureHeight * textureChannels]
+  GARMENT_BLOB_SECTION_COUNT
+};
+
+enum GarmentBlobFlags : uint32_t {
+  GARMENT_HAS_MESH = 1u << 0,
+  GARMENT_HAS_TEXTURE = 1u << 1,
+};
+
+/**
+ * @brief Blob header
+ */
+struct GarmentBlobHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t sectionCount;
+  uint64_t key; // Cache key (0 for server responses)
+  int32_t type;
+  uint32_t flags;
+  uint32_t vertexCount;
+  uint32_t faceCount;
+  uint32_t uvCount;
+  uint32_t weightRowCount;
+  uint32_t boneWeightCount;
+  uint32_t constraintCount;
+  int32_t textureWidth;
+  int32_t textureHeight;
+  int32_t textureChannels;
+  uint32_t reserved;
+};
+static_assert(sizeof(GarmentBlobHeader) == 72, "GarmentBlobHeader must be 72 bytes");
+
+/**
+ * @brief Location of one section inside the blob
+ */
+struct GarmentBlobSection {
+  uint64_t offset;
+  uint64_t size; // bytes
+};
+
+/**
+ * @brief Encode a garment
+ * @param key Value stored in the header
+ */
+inline Result<void> writeGarmentBlob(std::ostream &out, uint64_t key, const Garment &garment) {
+  auto mesh = garment.getMesh();
+  static const std::vector<Vertex> noVertices;
+  static const std::vector<Face> noFaces;
+  const auto &vertices = mesh ? mesh->getVertices() : noVertices;
+  const auto &faces = mesh ? mesh->getFaces() : noFaces;
+  const auto &uvs = garment.getUVCoords();
+  const auto &constraints = garment.getConstraints();
+  ImageData texels;
+  if (auto texture = garment.getTexture()) texels = texture->getData();
+  if (texels.pixels.size() != (size_t)texels.width * texels.height * texels.channels) {
+    return {.error = ErrorCode::INVALID_IMAGE, .message = "Garment texture size mismatch"};
+  }
+
+  // 頂点ごとのボーンウェイトはCSR形式に詰める
+  const auto &boneWeights = garment.getBoneWeights();
+  std::vector<uint32_t> rows(boneWeights.size() + 1, 0);
+  std::vector<Garment::BoneWeight> weights;
+  for (size_t i = 0; i < boneWeights.size(); ++i) {
+    weights.insert(weights.end(), boneWeights[i].begin(), boneWeights[i].end());
+    rows[i + 1] = static_cast<uint32_t>(weights.size());
+  }
+
+  GarmentBlobHeader header{};
+  std::memcpy(header.magic, GARMENT_BLOB_MAGIC, sizeof(header.magic));
+  header.version = GARMENT_BLOB_VERSION;
+  header.sectionCount = GARMENT_BLOB_SECTION_COUNT;
+  header.key = key;
+  header.type = static_cast<int32_t>(garment.getType());
+  header.flags = (mesh ? (uint32_t)GARMENT_HAS_MESH : 0u) | (garment.getTexture() ? (uint32_t)GARMENT_HAS_TEXTURE : 0u);
+  header.vertexCount = static_cast<uint32_t>(vertices.size());
+  header.faceCount = static_cast<uint32_t>(faces.size());
+  header.uvCount = static_cast<uint32_t>(uvs.size());
+  header.weightRowCount = static_cast<uint32_t>(boneWeights.size());
+  header.boneWeightCount = static_cast<uint32_t>(weights.size());
+  header.constraintCount = static_cast<uint32_t>(constraints.size());
+  header.textureWidth = texels.width;
+  header.textureHeight = texels.height;
+  header.textureChannels = texels.channels;
+
+  const void *payloads[GARMENT_BLOB_SECTION_COUNT] = {vertices.data(), faces.data(),   uvs.data(),
+                                                      rows.data(),     weights.data(), constraints.data(),
+                                                      texels.pixels.data()};
+  GarmentBlobSection sections[GARMENT_BLOB_SECTION_COUNT];
+  sections[GARMENT_SECTION_VERTICES].size = vertices.size() * sizeof(Vertex);
+  sections[GARMENT_SECTION_FACES].size = faces.size() * sizeof(Face);
+  sections[GARMENT_SECTION_UV_COORDS].size = uvs.size() * sizeof(Point2D);
+  sections[GARMENT_SECTION_WEIGHT_ROWS].size = rows.size() * sizeof(uint32_t);
+  sections[GARMENT_SECTION_BONE_WEIGHTS].size = weights.size() * sizeof(Garment::BoneWeight);
+  sections[GARMENT_SECTION_CONSTRAINTS].size = constraints.size() * sizeof(Garment::SpringConstraint);
+  sections[GARMENT_SECTION_TEXTURE].size = texels.pixels.size();
+
+  // 各セクションはアラインメント境界から始める
+  uint64_t offset = sizeof(header) + sizeof(sections);
+  for (auto &s : sections) {
+    offset = (offset + GARMENT_BLOB_ALIGNMENT - 1) / GARMENT_BLOB_ALIGNMENT * GARMENT_BLOB_ALIGNMENT;
+    s.offset = offset;
+    offset += s.size;
+  }
+
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(sections), sizeof(sections));
+  static const char padding[GARMENT_BLOB_ALIGNMENT] = {};
+  uint64_t written = sizeof(header) + sizeof(sections);
+  for (uint32_t i = 0; i < GARMENT_BLOB_SECTION_COUNT; ++i) {
+    out.write(padding, static_cast<std::streamsize>(sections[i].offset - written));
+    out.write(static_cast<const char *>(payloads[i]), static_cast<std::streamsize>(sections[i].size));
+    written = sections[i].offset + sections[i].size;
+  }
+  if (!out) {
+    return {.error = ErrorCode::IO_ERROR, .message = "Failed to write garment data"};
+  }
+  return {.error = ErrorCode::SUCCESS};
+}
+
+/**
+ * @brief Incremental garment blob decoder
+ *
+ * feed() accepts the blob in arbitrary pieces (a mapped file in one call,
+ * or network reads as they arrive). Payload bytes are copied straight into
+ * the final arrays, so the encoded blob is never held in memory as a whole.
+ * Header, table and sizes are validated before anything is allocated.
+ */
+class GarmentBlobDecoder {
+public:
+  static constexpr uint64_t MAX_BLOB_SIZE = 1ull << 30;
+  static constexpr int32_t MAX_TEXTURE_DIMENSION = 16384;
+
+  /**
+   * @brief Consume the next bytes of the blob
+   * @return false once the data is known to be invalid (see error())
+   */
+  bool feed(const uint8_t *data, size_t size) {
+    while (size > 0 && state != State::FAILED && state != State::DONE) {
+      size_t taken;
+      if (state == State::HEADER || state == State::TABLE) {
+        size_t target = sizeof(GarmentBlobHeader) + (state == State::TABLE ? tableBytes() : 0);
+        taken = std::min(size, target - prefix.size());
+        prefix.insert(prefix.end(), data, data + taken);
+        position += taken;
+        if (prefix.size() == target) {
+          if (state == State::HEADER) {
+            parseHeader();
+          } else {
+            parseTable();
+          }
+        }
+      } else {
+        taken = consumeBody(data, size);
+      }
+      data += taken;
+      size -= taken;
+    }
+    return state != State::FAILED;
+  }
+
+  /**
+   * @brief Whether every section has been received
+   */
+  bool complete() const { return state == State::DONE; }
+
+  const GarmentBlobHeader &header() const { return blobHeader; }
+  const std::string &error() const { return errorMessage; }
+
+  /**
+   * @brief Build the garment from a complete blob
+   * @return Garment, or nullptr if the blob is incomplete or inconsistent
+   */
+  std::shared_ptr<Garment> finish() {
+    if (state != State::DONE) {
+      if (state != State::FAILED) fail("Truncated garment data");
+      return nullptr;
+    }
+    const GarmentBlobHeader &h = blobHeader;
+    if (rows[h.weightRowCount] != h.boneWeightCount) {
+      fail("Inconsistent bone weights");
+      return nullptr;
+    }
+
+    auto garment = std::make_shared<Garment>();
+    garment->setType(static_cast<GarmentType>(h.type));
+
+    // 面の頂点番号はそのまま描画で使われるため範囲を確かめる
+    for (const Face &face : faces) {
+      for (uint32_t index : face.indices) {
+        if (index >= h.vertexCount) {
+          fail("Face index out of range");
+          return nullptr;
+        }
+      }
+    }
+
+    if (h.flags & GARMENT_HAS_MESH) {
+      auto mesh = std::make_shared<Mesh>();
+      mesh->setVertices(std::move(vertices));
+      mesh->setFaces(std::move(faces));
+      garment->setMesh(mesh);
+    }
+    garment->setUVCoords(std::move(uvs));
+
+    std::vector<std::vector<Garment::BoneWeight>> boneWeights(h.weightRowCount);
+    for (uint32_t i = 0; i < h.weightRowCount; ++i) {
+      if (rows[i] > rows[i + 1] || rows[i + 1] > h.boneWeightCount) {
+        fail("Inconsistent bone weights");
+        return nullptr;
+      }
+      boneWeights[i].assign(weights.begin() + rows[i], weights.begin() + rows[i + 1]);
+    }
+    garment->setBoneWeights(std::move(boneWeights));
+    garment->setConstraints(std::move(constraints));
+
+    if (h.flags & GARMENT_HAS_TEXTURE) {
+      auto texture = std::make_shared<Texture>();
+      texture->loadFromMemory(texels.data(), h.textureWidth, h.textureHeight, h.textureChannels);
+      garment->setTexture(texture);
+    }
+    return garment;
+  }
+
+private:
+  enum class State { HEADER, TABLE, BODY, DONE, FAILED };
+
+  State state = State::HEADER;
+  std::string errorMessage;
+  std::vector<uint8_t> prefix; // ヘッダーとセクション表
+  GarmentBlobHeader blobHeader{};
+  GarmentBlobSection sections[GARMENT_BLOB_SECTION_COUNT]{};
+  uint8_t *targets[GARMENT_BLOB_SECTION_COUNT]{};
+  uint64_t position = 0; // 受け取り済みのバイト数
+  uint64_t end = 0;      // 最後のセクションの終端
+  uint32_t current = 0;  // 書き込み中のセクション
+
+  std::vector<Vertex> vertices;
+  std::vector<Face> faces;
+  std::vector<Point2D> uvs;
+  std::vector<uint32_t> rows;
+  std::vector<Garment::BoneWeight> weights;
+  std::vector<Garment::SpringConstraint> constraints;
+  std::vector<uint8_t> texels;
+
+  void fail(const char *message) {
+    state = State::FAILED;
+    errorMessage = message;
+  }
+
+  size_t tableBytes() const { return (size_t)blobHeader.sectionCount * sizeof(GarmentBlobSection); }
+
+  void parseHeader() {
+    std::memcpy(&blobHeader, prefix.data(), sizeof(blobHeader));
+    const GarmentBlobHeader &h = blobHeader;
+    if (std::memcmp(h.magic, GARMENT_BLOB_MAGIC, sizeof(h.magic)) != 0) return fail("Not an ARFit garment");
+    if (h.version != GARMENT_BLOB_VERSION) return fail("Unsupported garment data version");
+    if (h.sectionCount < GARMENT_BLOB_SECTION_COUNT || h.sectionCount > 64) return fail("Bad section table");
+    // 積がオーバーフローしないよう、掛け合わせる前に各次元を制限する
+    if (h.textureWidth < 0 || h.textureWidth > MAX_TEXTURE_DIMENSION || h.textureHeight < 0 ||
+        h.textureHeight > MAX_TEXTURE_DIMENSION) {
+      return fail("Bad texture size");
+    }
+    if (h.flags & GARMENT_HAS_TEXTURE) {
+      if (h.textureWidth == 0 || h.textureHeight == 0 ||
+          (h.textureChannels != 1 && h.textureChannels != 3 && h.textureChannels != 4)) {
+        return fail("Bad texture size");
+      }
+    } else if (h.textureWidth != 0 || h.textureHeight != 0 || h.textureChannels < 0 || h.textureChannels > 4) {
+      return fail("Bad texture size");
+    }
+    state = State::TABLE;
+  }
+
+  void parseTable() {
+    std::memcpy(sections, prefix.data() + sizeof(GarmentBlobHeader), sizeof(sections));
+    const GarmentBlobHeader &h = blobHeader;
+    const uint64_t expected[GARMENT_BLOB_SECTION_COUNT] = {
+        (uint64_t)h.vertexCount * sizeof(Vertex),
+        (uint64_t)h.faceCount * sizeof(Face),
+        (uint64_t)h.uvCount * sizeof(Point2D),
+        ((uint64_t)h.weightRowCount + 1) * sizeof(uint32_t),
+        (uint64_t)h.boneWeightCount * sizeof(Garment::BoneWeight),
+        (uint64_t)h.constraintCount * sizeof(Garment::SpringConstraint),
+        (uint64_t)h.textureWidth * h.textureHeight * h.textureChannels};
+
+    // セクションは表の順に、重ならずに並んでいること
+    uint64_t cursor = prefix.size();
+    for (uint32_t i = 0; i < GARMENT_BLOB_SECTION_COUNT; ++i) {
+      const GarmentBlobSection &s = sections[i];
+      if (s.size != expected[i] || s.offset % GARMENT_BLOB_ALIGNMENT != 0 || s.offset < cursor ||
+          s.offset > MAX_BLOB_SIZE || s.size > MAX_BLOB_SIZE - s.offset) {
+        return fail("Bad section table");
+      }
+      cursor = s.offset + s.size;
+    }
+    end = cursor;
+
+    vertices.resize(h.vertexCount);
+    faces.resize(h.faceCount);
+    uvs.resize(h.uvCount);
+    rows.resize((size_t)h.weightRowCount + 1);
+    weights.resize(h.boneWeightCount);
+    constraints.resize(h.constraintCount);
+    texels.resize((size_t)expected[GARMENT_SECTION_TEXTURE]);
+    targets[GARMENT_SECTION_VERTICES] = reinterpret_cast<uint8_t *>(vertices.data());
+    targets[GARMENT_SECTION_FACES] = reinterpret_cast<uint8_t *>(faces.data());
+    targets[GARMENT_SECTION_UV_COORDS] = reinterpret_cast<uint8_t *>(uvs.data());
+    targets[GARMENT_SECTION_WEIGHT_ROWS] = reinterpret_cast<uint8_t *>(rows.data());
+    targets[GARMENT_SECTION_BONE_WEIGHTS] = reinterpret_cast<uint8_t *>(weights.data());
+    targets[GARMENT_SECTION_CONSTRAINTS] = reinterpret_cast<uint8_t *>(constraints.data());
+    targets[GARMENT_SECTION_TEXTURE] = texels.data();
+
+    state = position >= end ? State::DONE : State::BODY;
+  }
+
+  // 受け取ったバイトを該当セクションへ直接コピー（間のパディングは読み飛ばす）
+  size_t consumeBody(const uint8_t *data, size_t size) {
+    while (current < GARMENT_BLOB_SECTION_COUNT &&
+           position >= sections[current].offset + sections[current].size) {
+      ++current;
+    }
+    if (current == GARMENT_BLOB_SECTION_COUNT) {
+      state = State::DONE;
+      return 0;
+    }
+
+    const GarmentBlobSection &s = sections[current];
+    size_t taken;
+    if (position < s.offset) {
+      taken = (size_t)std::min<uint64_t>(size, s.offset - position);
+    } else {
+      taken = (size_t)std::min<uint64_t>(size, s.offset + s.size - position);
+      std::memcpy(targets[current] + (position - s.offset), data, taken);
+    }
+    position += taken;
+    if (position >= end) state = State::DONE;
+    return taken;
+  }
+};
+
+} // namespace arfit
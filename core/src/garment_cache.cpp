@@ -0,0 +1,236 @@
+/**
+ * @file garment_cache.cpp
+ * @brief 変換済み衣服のディスクキャッシュ実装
+ *
+ * 入力画像・衣服タイプ・変換設定のハッシュをキーに、変換結果を
+ * garment_blob.h の形式で保存します。読み込みはファイルをマップし、
+ * 各セクションをそのまま衣服データへコピーするだけです。
+ */
+
+#include "garment_cache.h"
+#include "atomic_file.h"
+#include "garment_blob.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace arfit {
+
+namespace {
+
+// ---- 64ビットハッシュ（xxHash64と同じ構成、32バイト単位で4系列を並行に混合） ----
+
+constexpr uint64_t PRIME1 = 11400714785074694791ull;
+constexpr uint64_t PRIME2 = 14029467366897019727ull;
+constexpr uint64_t PRIME3 = 1609587929392839161ull;
+constexpr uint64_t PRIME4 = 9650029242287828579ull;
+constexpr uint64_t PRIME5 = 2870177450012600261ull;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t read64(const uint8_t *p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t mixRound(uint64_t acc, uint64_t input) {
+  acc += input * PRIME2;
+  return rotl(acc, 31) * PRIME1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+  acc ^= mixRound(0, value);
+  return acc * PRIME1 + PRIME4;
+}
+
+uint64_t hashBytes(const void *data, size_t size, uint64_t seed) {
+  const auto *p = static_cast<const uint8_t *>(data);
+  const uint8_t *end = p + size;
+  uint64_t h;
+
+  if (size >= 32) {
+    uint64_t v1 = seed + PRIME1 + PRIME2, v2 = seed + PRIME2, v3 = seed, v4 = seed - PRIME1;
+    for (const uint8_t *limit = end - 32; p <= limit; p += 32) {
+      v1 = mixRound(v1, read64(p));
+      v2 = mixRound(v2, read64(p + 8));
+      v3 = mixRound(v3, read64(p + 16));
+      v4 = mixRound(v4, read64(p + 24));
+    }
+    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    h = mergeRound(h, v1);
+    h = mergeRound(h, v2);
+    h = mergeRound(h, v3);
+    h = mergeRound(h, v4);
+  } else {
+    h = seed + PRIME5;
+  }
+  h += size;
+
+  for (; p + 8 <= end; p += 8) h = rotl(h ^ mixRound(0, read64(p)), 27) * PRIME1 + PRIME4;
+  if (p + 4 <= end) {
+    h = rotl(h ^ (read32(p) * PRIME1), 23) * PRIME2 + PRIME3;
+    p += 4;
+  }
+  for (; p < end; ++p) h = rotl(h ^ (*p * PRIME5), 11) * PRIME1;
+
+  h ^= h >> 33;
+  h *= PRIME2;
+  h ^= h >> 29;
+  h *= PRIME3;
+  h ^= h >> 32;
+  return h;
+}
+
+template <typename T>
+uint64_t hashValue(const T &value, uint64_t seed) {
+  return hashBytes(&value, sizeof(value), seed);
+}
+
+/**
+ * 読み取り専用でファイル全体をマップ（Windowsでは読み込みで代替）
+ */
+class MappedFile {
+public:
+  ~MappedFile() {
+#if !defined(_WIN32)
+    if (mapped) munmap(const_cast<uint8_t *>(data), size);
+#endif
+  }
+
+  bool open(const std::string &path) {
+#if defined(_WIN32)
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    buffer.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char *>(buffer.data()), buffer.size())) return false;
+    data = buffer.data();
+    size = buffer.size();
+    return true;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+      close(fd);
+      return false;
+    }
+    void *addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return false;
+    data = static_cast<const uint8_t *>(addr);
+    size = static_cast<size_t>(st.st_size);
+    mapped = true;
+    return true;
+#endif
+  }
+
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+
+private:
+  bool mapped = false;
+  std::vector<uint8_t> buffer;
+};
+
+} // namespace
+
+class GarmentCache::Impl {
+public:
+  GarmentCacheConfig config;
+  bool initialized = false;
+  mutable std::mutex mutex; // 書き込みの直列化（読み込みはリネームの原子性に任せる）
+
+  std::filesystem::path pathFor(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.garment", static_cast<unsigned long long>(key));
+    return std::filesystem::path(config.directory) / name;
+  }
+
+  std::shared_ptr<Garment> read(uint64_t key) const {
+    MappedFile file;
+    if (!file.open(pathFor(key).string())) return nullptr;
+
+    GarmentBlobDecoder decoder;
+    if (!decoder.feed(file.data, file.size) || !decoder.complete() || decoder.header().key != key) {
+      return nullptr;
+    }
+    return decoder.finish();
+  }
+};
+
+GarmentCache::GarmentCache() : pImpl(std::make_unique<Impl>()) {}
+GarmentCache::~GarmentCache() = default;
+
+Result<void> GarmentCache::initialize(const GarmentCacheConfig &config) {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  pImpl->config = config;
+
+  std::error_code ec;
+  std::filesystem::create_directories(config.directory, ec);
+  if (ec) {
+    return {.error = ErrorCode::IO_ERROR,
+            .message = "Cannot create garment cache directory: " + ec.message()};
+  }
+
+  pImpl->initialized = true;
+  return {.error = ErrorCode::SUCCESS};
+}
+
+uint64_t GarmentCache::key(const ImageData &image, GarmentType type, const GarmentConverterConfig &config) {
+  // 形式バージョンも含め、保存形式や変換結果が変わればキーも変わるようにする
+  uint64_t hash = hashValue(GARMENT_BLOB_VERSION, 0);
+  hash = hashValue(type, hash);
+  hash = hashValue(image.width, hash);
+  hash = hashValue(image.height, hash);
+  hash = hashValue(image.channels, hash);
+  hash = hashValue(config.useServerProcessing, hash);
+  hash = hashBytes(config.serverEndpoint.data(), config.serverEndpoint.size(), hash);
+  hash = hashValue(config.maxTextureSize, hash);
+  hash = hashValue(config.meshResolution, hash);
+  hash = hashValue(config.generateNormalMap, hash);
+  hash = hashValue(config.generateDisplacementMap, hash);
+  return hashBytes(image.pixels.data(), image.pixels.size(), hash);
+}
+
+std::shared_ptr<Garment> GarmentCache::load(uint64_t key) const {
+  {
+    std::lock_guard<std::mutex> lock(pImpl->mutex);
+    if (!pImpl->initialized) return nullptr;
+  }
+  return pImpl->read(key);
+}
+
+Result<void> GarmentCache::store(uint64_t key, const Garment &garment) {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  if (!pImpl->initialized) {
+    return {.error = ErrorCode::INITIALIZATION_FAILED, .message = "Garment cache not initialized"};
+  }
+
+  return writeFileAtomically(pImpl->pathFor(key),
+                             [&](std::ofstream &out) { return writeGarmentBlob(out, key, garment); });
+}
+
+bool GarmentCache::isInitialized() const {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  return pImpl->initialized;
+}
+
+} // namespace arfit
@@ -4,8 +4,17 @@
  */
 
 #include "garment_converter.h"
+#include "conversion_client.h"
+#include "silhouette_index.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cmath>
+#include <cstring>
+#include <future>
 #include <iostream>
+#include <mutex>
 #include <opencv2/opencv.hpp>
 #include <vector>
 
@@ -37,6 +46,27 @@ std::shared_ptr<Mesh> Garment::getMesh() const { return pImpl->mesh; }
 void Garment::setMesh(std::shared_ptr<Mesh> mesh) { pImpl->mesh = mesh; }
 std::shared_ptr<Texture> Garment::getTexture() const { return pImpl->texture; }
 void Garment::setTexture(std::shared_ptr<Texture> texture) { pImpl->texture = texture; }
+const std::vector<std::vector<Garment::BoneWeight>> &Garment::getBoneWeights() const { return pImpl->boneWeights; }
+void Garment::setBoneWeights(std::vector<std::vector<BoneWeight>> weights) { pImpl->boneWeights = std::move(weights); }
+const std::vector<Point2D> &Garment::getUVCoords() const { return pImpl->uvCoords; }
+void Garment::setUVCoords(std::vector<Point2D> uvCoords) { pImpl->uvCoords = std::move(uvCoords); }
+const std::vector<Garment::SpringConstraint> &Garment::getConstraints() const { return pImpl->constraints; }
+void Garment::setConstraints(std::vector<SpringConstraint> constraints) { pImpl->constraints = std::move(constraints); }
+
+namespace {
+
+// これより不透明なアルファを衣服の前景とみなす
+constexpr uint8_t ALPHA_THRESHOLD = 128;
+
+/**
+ * 1枚の変換で使う作業領域（変換間で使い回す）
+ */
+struct ConversionScratch {
+  std::vector<uint8_t> mask;
+  SilhouetteIndex silhouette;
+};
+
+} // namespace
 
 /**
  * @brief GarmentConverterの内部実装
@@ -46,8 +76,15 @@ public:
   GarmentConverterConfig config;
 
   // 衣服の形状テンプレート
-  std::shared_ptr<Mesh> tshirtTemplate;
-  std::shared_ptr<Mesh> pantsTemplate;
+  // 衣服タイプごとに全解像度レベルを事前生成（変換時に端末に合わせて選ぶ）
+  static constexpr int NUM_GARMENT_TYPES = static_cast<int>(GarmentType::SKIRT) + 1;
+  std::array<std::array<std::shared_ptr<Mesh>, MESH_TEMPLATE_LEVEL_COUNT>, NUM_GARMENT_TYPES> templates;
+
+  // convert() 用の作業領域（バッチ変換では作業スレッドごとに別のものを使う）
+  ConversionScratch scratch;
+
+  // サーバー変換用クライアント（サーバー処理が有効な場合のみ）
+  std::unique_ptr<ConversionClient> serverClient;
 
   Impl() { initializeTemplates(); }
 
@@ -55,13 +92,17 @@ public:
    * 基本的な形状テンプレートを生成
    */
   void initializeTemplates() {
-    tshirtTemplate = Mesh::createTShirtTemplate();
+    for (int type = 0; type < NUM_GARMENT_TYPES; ++type) {
+      for (int level = 0; level < MESH_TEMPLATE_LEVEL_COUNT; ++level) {
+        templates[type][level] = Mesh::createTemplate(static_cast<GarmentType>(type), MESH_TEMPLATE_LEVELS[level]);
+      }
+    }
   }
 
   /**
    * 画像から衣服の種類を推定
    */
-  GarmentType detectType(const cv::Mat &image) {
+  GarmentType detectType(const cv::Mat &image) const {
     float aspect = static_cast<float>(image.cols) / image.rows;
     if (aspect > 0.8f) return GarmentType::TSHIRT;
     if (aspect < 0.5f) return GarmentType::DRESS;
@@ -70,57 +111,64 @@ public:
 
   /**
    * 衣服の領域を切り出し（セグメンテーション）
+   *
+   * 二値マスクを作業領域に書き込み、行区間インデックスも同時に作る。
+   * 返すマスクは作業領域を参照する。
    */
-  cv::Mat segmentGarment(const cv::Mat &input) {
-    cv::Mat mask;
+  cv::Mat segmentGarment(const cv::Mat &input, ConversionScratch &scratch) const {
+    scratch.mask.resize((size_t)input.rows * input.cols);
+    cv::Mat mask(input.rows, input.cols, CV_8UC1, scratch.mask.data());
     if (input.channels() == 4) {
-      std::vector<cv::Mat> channels;
-      cv::split(input, channels);
-      mask = channels[3]; // アルファチャンネルをマスクとして使用
+      // アルファチャンネルを直接しきい値処理（チャンネル分離の中間画像を作らない）
+      thresholdAlpha(input.ptr<uint8_t>(), input.step[0], input.cols, input.rows, scratch.mask.data(),
+                     input.cols, ALPHA_THRESHOLD);
     } else {
-      mask = cv::Mat::zeros(input.size(), CV_8UC1);
+      std::fill(scratch.mask.begin(), scratch.mask.end(), (uint8_t)0);
       cv::ellipse(mask, cv::Point(input.cols / 2, input.rows / 2),
                   cv::Size(input.cols / 3, input.rows / 3), 0, 0, 360,
                   cv::Scalar(255), -1);
     }
+
+    // 背景に残ったアルファの欠片を除き、最大の連結成分だけを衣服とみなす
+    scratch.silhouette.build(scratch.mask.data(), input.cols, input.rows, input.cols, 0);
+    scratch.silhouette.retainLargestComponent(scratch.mask.data(), input.cols);
     return mask;
   }
 
   /**
    * 2Dのシルエットに合わせて3Dメッシュを変形（フィッティング）
    */
-  void fitMeshToSilhouette(std::shared_ptr<Mesh> mesh, const cv::Mat &mask) {
+  void fitMeshToSilhouette(std::shared_ptr<Mesh> mesh, const cv::Mat &mask, const SilhouetteIndex &silhouette) const {
     if (!mesh || mask.empty()) return;
 
-    cv::Rect bounds = cv::boundingRect(mask);
-    auto &vertices = const_cast<std::vector<Vertex> &>(mesh->getVertices());
-    
-    for (auto &v : vertices) {
+    SilhouetteBounds bounds = silhouette.bounds();
+
+    // 各頂点は行の外周区間を引くだけなので頂点間で並列化できる
+    auto &vertices = mesh->getVerticesMutable();
+    ThreadPool::shared().parallelFor(0, vertices.size(), 1024, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        Vertex &v = vertices[i];
         // Y座標に基づいてマスクの高さをマッピング
         int yInMask = bounds.y + (1.0f - (v.position.y + 0.5f)) * bounds.height;
         yInMask = std::clamp(yInMask, 0, mask.rows - 1);
-        
-        cv::Mat row = mask.row(yInMask);
-        int left = -1, right = -1;
-        for (int x = 0; x < row.cols; ++x) {
-            if (row.at<uint8_t>(x) > 128) { if (left == -1) left = x; right = x; }
-        }
-        
-        if (left != -1 && right != -1) {
-            float silhouetteWidth = static_cast<float>(right - left) / mask.cols;
-            // テンプレートの幅に対してシルエットの幅を適用
-            v.position.x *= (silhouetteWidth * 2.5f); 
+
+        const SilhouetteSpan &extent = silhouette.extent(yInMask);
+        if (!extent.empty()) {
+          float silhouetteWidth = static_cast<float>(extent.right - extent.left) / mask.cols;
+          // テンプレートの幅に対してシルエットの幅を適用
+          v.position.x *= (silhouetteWidth * 2.5f);
         }
-        
+
         // 厚みも少し調整
         v.position.z = std::abs(v.position.x) * 0.15f;
-    }
+      }
+    });
   }
 
   /**
    * メッシュを人体のボーンに紐付ける（リギング）
    */
-  std::vector<std::vector<Garment::BoneWeight>> rigToBody(std::shared_ptr<Mesh> mesh, GarmentType type) {
+  std::vector<std::vector<Garment::BoneWeight>> rigToBody(std::shared_ptr<Mesh> mesh, GarmentType type) const {
     const auto& vertices = mesh->getVertices();
     std::vector<std::vector<Garment::BoneWeight>> weights(vertices.size());
 
@@ -151,6 +199,118 @@ public:
     }
     return weights;
   }
+
+  /**
+   * 1枚の画像を変換（セグメンテーション→フィッティング→リギング→テクスチャ）
+   */
+  Result<std::shared_ptr<Garment>> convertImage(const ImageData &image, GarmentType type, float meshResolution,
+                                                ConversionScratch &scratch) const {
+    if (image.width <= 0 || image.height <= 0 || image.channels != 4 ||
+        image.pixels.size() < (size_t)image.width * image.height * 4) {
+      return {.error = ErrorCode::INVALID_IMAGE, .message = "Expected a non-empty RGBA image"};
+    }
+
+    auto garment = std::make_shared<Garment>();
+    cv::Mat cvImage(image.height, image.width, CV_8UC4, const_cast<uint8_t *>(image.pixels.data()));
+
+    if (type == GarmentType::UNKNOWN) {
+      type = detectType(cvImage);
+    }
+    garment->setType(type);
+
+    cv::Mat mask = segmentGarment(cvImage, scratch);
+
+    int typeIndex = std::clamp(static_cast<int>(type), 0, NUM_GARMENT_TYPES - 1);
+    std::shared_ptr<Mesh> templateMesh = templates[typeIndex][Mesh::templateLevel(meshResolution)];
+    if (templateMesh) {
+      auto deformedMesh = std::make_shared<Mesh>(*templateMesh);
+      fitMeshToSilhouette(deformedMesh, mask, scratch.silhouette);
+      garment->setMesh(deformedMesh);
+
+      // リギング情報の生成（描画直前のポーズ補正に使う）
+      garment->setBoneWeights(rigToBody(garment->getMesh(), type));
+    }
+
+    auto texture = std::make_shared<Texture>();
+    texture->loadFromMemory(image.pixels.data(), image.width, image.height, image.channels);
+    garment->setTexture(texture);
+
+    return {.value = garment, .error = ErrorCode::SUCCESS};
+  }
+
+  /**
+   * 画像ファイルをRGBAとして読み込む
+   */
+  static Result<ImageData> decodeImage(const std::string &path) {
+    cv::Mat image = cv::imread(path, cv::IMREAD_UNCHANGED);
+    if (image.empty()) {
+      return {.error = ErrorCode::IO_ERROR, .message = "Failed to read image: " + path};
+    }
+
+    cv::Mat rgba;
+    if (image.channels() == 4) {
+      cv::cvtColor(image, rgba, cv::COLOR_BGRA2RGBA);
+    } else if (image.channels() == 3) {
+      cv::cvtColor(image, rgba, cv::COLOR_BGR2RGBA);
+    } else if (image.channels() == 1) {
+      cv::cvtColor(image, rgba, cv::COLOR_GRAY2RGBA);
+    } else {
+      return {.error = ErrorCode::INVALID_IMAGE, .message = "Unsupported channel count: " + path};
+    }
+
+    ImageData data;
+    data.width = rgba.cols;
+    data.height = rgba.rows;
+    data.channels = 4;
+    data.pixels.resize(rgba.total() * rgba.elemSize());
+    std::memcpy(data.pixels.data(), rgba.data, data.pixels.size());
+    return {.value = std::move(data), .error = ErrorCode::SUCCESS};
+  }
+
+  /**
+   * バッチ変換の共通部分
+   *
+   * プールのスレッド数（または maxInFlight）だけ作業レーンを立て、各レーンが
+   * 次の項目を取っては最後まで処理する。同時に保持される画像・中間データは
+   * レーン数で抑えられる。
+   */
+  template <typename ConvertItem>
+  Result<void> runBatch(size_t count, const GarmentBatchCallback &onResult, const GarmentBatchOptions &options,
+                        ConvertItem &&convertItem) const {
+    ThreadPool &pool = ThreadPool::shared();
+    size_t lanes = options.maxInFlight > 0 ? (size_t)options.maxInFlight : pool.size() + 1;
+    lanes = std::min(lanes, count);
+
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failures{0};
+    std::mutex callbackMutex;
+
+    pool.parallelFor(0, lanes, 1, [&](size_t, size_t) {
+      ConversionScratch laneScratch;
+      size_t index;
+      while ((index = next.fetch_add(1)) < count) {
+        Result<std::shared_ptr<Garment>> result;
+        try {
+          result = convertItem(index, laneScratch);
+        } catch (const std::exception &e) {
+          // 1件の失敗でバッチ全体を止めない
+          result = {.error = ErrorCode::GARMENT_CONVERSION_FAILED, .message = e.what()};
+        }
+        if (!result) failures.fetch_add(1);
+
+        if (onResult) {
+          std::lock_guard<std::mutex> lock(callbackMutex);
+          onResult(index, std::move(result));
+        }
+      }
+    });
+
+    if (failures.load() > 0) {
+      return {.error = ErrorCode::GARMENT_CONVERSION_FAILED,
+              .message = std::to_string(failures.load()) + " of " + std::to_string(count) + " items failed"};
+    }
+    return {.error = ErrorCode::SUCCESS};
+  }
 };
 
 GarmentConverter::GarmentConverter() : pImpl(std::make_unique<Impl>()) {}
@@ -159,41 +319,58 @@ GarmentConverter::~GarmentConverter() = default;
 Result<void>
 GarmentConverter::initialize(const GarmentConverterConfig &config) {
   pImpl->config = config;
+
+  // 旧クライアントの未完了要求はここでエラー通知される
+  pImpl->serverClient.reset();
+  if (config.useServerProcessing && !config.serverEndpoint.empty()) {
+    ConversionClientConfig clientConfig;
+    clientConfig.endpoint = config.serverEndpoint;
+    pImpl->serverClient = std::make_unique<ConversionClient>(clientConfig);
+  }
   return {.error = ErrorCode::SUCCESS};
 }
 
 Result<std::shared_ptr<Garment>>
 GarmentConverter::convert(const ImageData &image, GarmentType type) {
-  auto garment = std::make_shared<Garment>();
-  cv::Mat cvImage(image.height, image.width, CV_8UC4, const_cast<uint8_t *>(image.pixels.data()));
-
-  if (type == GarmentType::UNKNOWN) {
-    type = pImpl->detectType(cvImage);
-  }
-  garment->setType(type);
-
-  cv::Mat mask = pImpl->segmentGarment(cvImage);
-
-  std::shared_ptr<Mesh> templateMesh = pImpl->tshirtTemplate;
-  if (templateMesh) {
-    auto deformedMesh = std::make_shared<Mesh>(*templateMesh);
-    pImpl->fitMeshToSilhouette(deformedMesh, mask);
-    garment->setMesh(deformedMesh);
-    
-    // リギング情報の生成 (TODO: Garmentクラスに保存用メンバを追加)
-    auto weights = pImpl->rigToBody(garment->getMesh(), type);
-  }
+  return pImpl->convertImage(image, type, pImpl->config.meshResolution, pImpl->scratch);
+}
 
-  auto texture = std::make_shared<Texture>();
-  texture->loadFromMemory(image.pixels.data(), image.width, image.height, image.channels);
-  garment->setTexture(texture);
+Result<void> GarmentConverter::convertBatch(const std::vector<ImageData> &images,
+                                            const GarmentBatchCallback &onResult,
+                                            const GarmentBatchOptions &options) {
+  float resolution = options.meshResolution >= 0.0f ? options.meshResolution : pImpl->config.meshResolution;
+  return pImpl->runBatch(images.size(), onResult, options, [&](size_t index, ConversionScratch &scratch) {
+    return pImpl->convertImage(images[index], options.type, resolution, scratch);
+  });
+}
 
-  return {.value = garment, .error = ErrorCode::SUCCESS};
+Result<void> GarmentConverter::convertBatch(const std::vector<std::string> &paths,
+                                            const GarmentBatchCallback &onResult,
+                                            const GarmentBatchOptions &options) {
+  float resolution = options.meshResolution >= 0.0f ? options.meshResolution : pImpl->config.meshResolution;
+  return pImpl->runBatch(paths.size(), onResult, options,
+                         [&](size_t index, ConversionScratch &scratch) -> Result<std::shared_ptr<Garment>> {
+                           // デコードもレーン内で行い、読み込んだ画像は変換後すぐ解放
+                           Result<ImageData> decoded = Impl::decodeImage(paths[index]);
+                           if (!decoded) return {.error = decoded.error, .message = decoded.message};
+                           return pImpl->convertImage(decoded.value, options.type, resolution, scratch);
+                         });
 }
 
 Result<std::shared_ptr<Garment>>
 GarmentConverter::convertFromServer(const std::string &url) {
-  return {.error = ErrorCode::NETWORK_ERROR, .message = "Not implemented"};
+  std::promise<Result<std::shared_ptr<Garment>>> promise;
+  auto future = promise.get_future();
+  convertFromServerAsync(url, [&promise](const Result<std::shared_ptr<Garment>> &result) { promise.set_value(result); });
+  return future.get();
+}
+
+void GarmentConverter::convertFromServerAsync(const std::string &url, ConversionCallback callback) {
+  if (!pImpl->serverClient) {
+    callback({.error = ErrorCode::NETWORK_ERROR, .message = "Server processing not configured"});
+    return;
+  }
+  pImpl->serverClient->convert(url, std::move(callback));
 }
 
 Result<void>
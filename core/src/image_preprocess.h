@@ -0,0 +1,166 @@
+/**
+ * @file image_preprocess.h
+ * @brief Fused crop / letterbox-resize / normalize into a model input tensor (internal)
+ */
+
+#pragma once
+
+#include "pose_estimator.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace arfit {
+
+/**
+ * @brief Crop rectangle in source pixels
+ */
+struct CropRegion {
+  float x = 0.0f;
+  float y = 0.0f;
+  float width = 0.0f;
+  float height = 0.0f;
+};
+
+/**
+ * @brief Writes a bilinearly resampled, letterboxed RGB crop straight into a tensor
+ *
+ * Reads only the 2x2 source taps of each output pixel, drops alpha and
+ * applies normalization in the same pass, so no full-frame intermediate is
+ * produced. Sampling tables are kept between calls.
+ */
+class LetterboxResampler {
+public:
+  void run(const ImageData &image, const CropRegion &crop, PoseInputTensor &tensor) {
+    const int W = tensor.width, H = tensor.height;
+    const int channels = image.channels;
+
+    // レターボックス配置（縦横比を保って中央寄せ）
+    float scale = std::min(W / crop.width, H / crop.height);
+    int contentWidth = std::clamp((int)std::lround(crop.width * scale), 1, W);
+    int contentHeight = std::clamp((int)std::lround(crop.height * scale), 1, H);
+    int padX = (W - contentWidth) / 2, padY = (H - contentHeight) / 2;
+
+    LetterboxTransform &t = tensor.transform;
+    t.tensorWidth = W;
+    t.tensorHeight = H;
+    t.sourceWidth = image.width;
+    t.sourceHeight = image.height;
+    t.cropOrigin = {crop.x, crop.y};
+    t.scale = scale;
+    t.pad = {(float)padX, (float)padY};
+
+    // 列・行ごとのサンプリング位置と重み
+    buildTaps(crop.x, scale, contentWidth, image.width, columns);
+    buildTaps(crop.y, scale, contentHeight, image.height, rows);
+
+    const bool asFloat = tensor.format == PoseTensorFormat::FLOAT32;
+    const float norm = asFloat ? 1.0f / 255.0f : 1.0f;
+    const size_t stride = (size_t)image.width * channels;
+
+    ThreadPool::shared().parallelFor(0, H, 16, [&](size_t begin, size_t end) {
+      alignas(16) float pixel[4];
+      for (size_t y = begin; y < end; ++y) {
+        float *dstF = asFloat ? &tensor.data[y * W * 3] : nullptr;
+        uint8_t *dstB = asFloat ? nullptr : &tensor.bytes[y * W * 3];
+
+        // 余白行・余白列はゼロ埋め
+        int cy = (int)y - padY;
+        if (cy < 0 || cy >= contentHeight) {
+          if (asFloat) std::fill_n(dstF, W * 3, 0.0f);
+          else std::fill_n(dstB, W * 3, 0);
+          continue;
+        }
+        if (asFloat) {
+          std::fill_n(dstF, padX * 3, 0.0f);
+          std::fill_n(dstF + (padX + contentWidth) * 3, (W - padX - contentWidth) * 3, 0.0f);
+          dstF += padX * 3;
+        } else {
+          std::fill_n(dstB, padX * 3, 0);
+          std::fill_n(dstB + (padX + contentWidth) * 3, (W - padX - contentWidth) * 3, 0);
+          dstB += padX * 3;
+        }
+
+        const Tap &row = rows[cy];
+        const uint8_t *r0 = &image.pixels[row.i0 * stride];
+        const uint8_t *r1 = &image.pixels[row.i1 * stride];
+        simd::Float4 wy0 = simd::splat((1.0f - row.f) * norm);
+        simd::Float4 wy1 = simd::splat(row.f * norm);
+
+        for (int cx = 0; cx < contentWidth; ++cx) {
+          const Tap &col = columns[cx];
+          simd::Float4 v;
+          if (channels == 4) {
+            // 1画素 (RGBA) を1ベクトルとして2x2タップを補間
+            simd::Float4 fx = simd::splat(col.f);
+            simd::Float4 a = simd::loadBytes(r0 + col.i0 * 4), b = simd::loadBytes(r0 + col.i1 * 4);
+            simd::Float4 c = simd::loadBytes(r1 + col.i0 * 4), d = simd::loadBytes(r1 + col.i1 * 4);
+            simd::Float4 top = simd::madd(fx, b - a, a);
+            simd::Float4 bottom = simd::madd(fx, d - c, c);
+            v = simd::madd(top, wy0, bottom * wy1);
+          } else {
+            v = sampleGeneric(r0, r1, col, row.f, channels, norm);
+          }
+
+          // 4レーン書き込みの余分な1要素は次の画素で上書きされる（末尾のみ3要素）
+          bool last = cx + 1 == contentWidth;
+          if (asFloat) {
+            if (!last) {
+              simd::store(dstF + cx * 3, v);
+            } else {
+              simd::store(pixel, v);
+              std::copy_n(pixel, 3, dstF + cx * 3);
+            }
+          } else {
+            if (!last) {
+              simd::storeBytes(dstB + cx * 3, v);
+            } else {
+              uint8_t bytes[4];
+              simd::storeBytes(bytes, v);
+              std::copy_n(bytes, 3, dstB + cx * 3);
+            }
+          }
+        }
+      }
+    });
+  }
+
+private:
+  struct Tap {
+    size_t i0;
+    size_t i1;
+    float f; // i1 の重み
+  };
+
+  static void buildTaps(float origin, float scale, int count, int limit, std::vector<Tap> &taps) {
+    taps.resize(count);
+    for (int i = 0; i < count; ++i) {
+      float src = origin + (i + 0.5f) / scale - 0.5f;
+      float base = std::floor(src);
+      int i0 = std::clamp((int)base, 0, limit - 1);
+      int i1 = std::clamp((int)base + 1, 0, limit - 1);
+      taps[i] = {(size_t)i0, (size_t)i1, std::clamp(src - base, 0.0f, 1.0f)};
+    }
+  }
+
+  // RGB / グレースケール入力用のスカラー経路
+  static simd::Float4 sampleGeneric(const uint8_t *r0, const uint8_t *r1, const Tap &col,
+                                    float fy, int channels, float norm) {
+    alignas(16) float out[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    for (int c = 0; c < 3; ++c) {
+      int ch = std::min(c, channels - 1);
+      float a = r0[col.i0 * channels + ch], b = r0[col.i1 * channels + ch];
+      float d0 = r1[col.i0 * channels + ch], d1 = r1[col.i1 * channels + ch];
+      float top = a + (b - a) * col.f, bottom = d0 + (d1 - d0) * col.f;
+      out[c] = (top + (bottom - top) * fy) * norm;
+    }
+    return simd::load(out);
+  }
+
+  std::vector<Tap> columns;
+  std::vector<Tap> rows;
+};
+
+} // namespace arfit
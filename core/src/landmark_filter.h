@@ -0,0 +1,104 @@
+/**
+ * @file landmark_filter.h
+ * @brief Speed-adaptive One-Euro filter over all landmark channels (internal)
+ */
+
+#pragma once
+
+#include "simd.h"
+#include "types.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace arfit {
+
+/**
+ * @brief One-Euro filter parameters
+ */
+struct OneEuroParams {
+  float minCutoff = 1.0f;        // Hz, cutoff when still (lower = less jitter)
+  float beta = 10.0f;            // Cutoff increase per unit/s of speed (higher = less lag)
+  float derivativeCutoff = 1.0f; // Hz, smoothing of the speed estimate
+};
+
+/**
+ * @brief One-Euro filter for 33 landmarks, state kept as SoA x/y/z planes
+ *
+ * Each of the 99 channels gets its own cutoff from its filtered speed, so
+ * still landmarks are smoothed heavily while fast ones follow with little
+ * lag. The whole update is a handful of 4-wide operations per plane.
+ */
+class LandmarkFilter {
+public:
+  static constexpr int NUM_LANDMARKS = 33;
+
+  void reset() { initialized = false; }
+
+  /**
+   * @brief Filter landmarks in place
+   * @param timestamp Frame time in seconds (non-increasing times fall back to 30 fps)
+   */
+  void apply(std::array<Point3D, NUM_LANDMARKS> &landmarks, float timestamp, const OneEuroParams &params) {
+    alignas(16) float input[NUM_CHANNELS];
+    for (int i = 0; i < NUM_LANDMARKS; ++i) {
+      input[i] = landmarks[i].x;
+      input[PLANE + i] = landmarks[i].y;
+      input[2 * PLANE + i] = landmarks[i].z;
+    }
+    for (int p = 0; p < 3; ++p) {
+      for (int i = NUM_LANDMARKS; i < PLANE; ++i) input[p * PLANE + i] = 0.0f;
+    }
+
+    if (!initialized) {
+      std::copy_n(input, NUM_CHANNELS, value.data());
+      derivative.fill(0.0f);
+      lastTimestamp = timestamp;
+      initialized = true;
+      return;
+    }
+
+    float dt = timestamp - lastTimestamp;
+    if (!(dt > 0.0f)) dt = 1.0f / 30.0f;
+    lastTimestamp = timestamp;
+
+    // α = r / (1 + r), r = 2π·fc·dt
+    const float TWO_PI = 6.28318531f;
+    float rd = TWO_PI * params.derivativeCutoff * dt;
+    simd::Float4 alphaD = simd::splat(rd / (1.0f + rd));
+    simd::Float4 invDt = simd::splat(1.0f / dt);
+    simd::Float4 minCutoff = simd::splat(TWO_PI * params.minCutoff * dt);
+    simd::Float4 beta = simd::splat(TWO_PI * params.beta * dt);
+    simd::Float4 one = simd::splat(1.0f);
+
+    for (int i = 0; i < NUM_CHANNELS; i += 4) {
+      simd::Float4 x = simd::load(input + i);
+      simd::Float4 prev = simd::load(&value[i]);
+      simd::Float4 delta = x - prev;
+
+      // 速度を平滑化し、その大きさでカットオフ周波数を上げる
+      simd::Float4 dx = simd::load(&derivative[i]);
+      dx = simd::madd(alphaD, simd::madd(delta, invDt, simd::zero() - dx), dx);
+      simd::Float4 r = simd::madd(beta, simd::abs(dx), minCutoff);
+      simd::Float4 alpha = r / (one + r);
+
+      simd::store(&derivative[i], dx);
+      simd::store(&value[i], simd::madd(alpha, delta, prev));
+    }
+
+    for (int i = 0; i < NUM_LANDMARKS; ++i) {
+      landmarks[i] = {value[i], value[PLANE + i], value[2 * PLANE + i]};
+    }
+  }
+
+private:
+  static constexpr int PLANE = (NUM_LANDMARKS + 3) & ~3; // 1平面を4の倍数にパディング
+  static constexpr int NUM_CHANNELS = 3 * PLANE;
+
+  alignas(16) std::array<float, NUM_CHANNELS> value{};
+  alignas(16) std::array<float, NUM_CHANNELS> derivative{};
+  float lastTimestamp = 0.0f;
+  bool initialized = false;
+};
+
+} // namespace arfit
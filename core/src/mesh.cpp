@@ -4,10 +4,62 @@
  */
 
 #include "mesh.h"
+#include <algorithm>
+#include <cfloat>
 #include <cmath>
 
 namespace arfit {
 
+namespace {
+
+/**
+ * Build a template from a rows x cols vertex grid.
+ * position(r, c, t, v) gives the vertex position for column fraction t and
+ * row fraction v (both 0-1, also used as UVs); quads for which skip(r, c)
+ * returns true are left open.
+ */
+template <typename PositionFn, typename SkipFn>
+std::shared_ptr<Mesh> buildGridTemplate(int rows, int cols, PositionFn &&position, SkipFn &&skip) {
+  auto mesh = std::make_shared<Mesh>();
+  rows = std::max(rows, 2);
+  cols = std::max(cols, 2);
+
+  std::vector<Vertex> vertices;
+  vertices.reserve(static_cast<size_t>(rows) * cols);
+  for (int r = 0; r < rows; ++r) {
+    float v = float(r) / (rows - 1);
+    for (int c = 0; c < cols; ++c) {
+      float t = float(c) / (cols - 1);
+      Vertex vertex;
+      vertex.position = position(r, c, t, v);
+      vertex.normal = {0, 0, 1};
+      vertex.texCoord = {t, v};
+      vertices.push_back(vertex);
+    }
+  }
+
+  std::vector<Face> faces;
+  faces.reserve(static_cast<size_t>(rows - 1) * (cols - 1) * 2);
+  for (int r = 0; r < rows - 1; ++r) {
+    for (int c = 0; c < cols - 1; ++c) {
+      if (skip(r, c)) continue;
+      int i = r * cols + c;
+      faces.push_back({{static_cast<uint32_t>(i), static_cast<uint32_t>(i + 1),
+                        static_cast<uint32_t>(i + cols + 1)}});
+      faces.push_back(
+          {{static_cast<uint32_t>(i), static_cast<uint32_t>(i + cols + 1),
+            static_cast<uint32_t>(i + cols)}});
+    }
+  }
+
+  mesh->setVertices(std::move(vertices));
+  mesh->setFaces(std::move(faces));
+  mesh->calculateNormals();
+  return mesh;
+}
+
+} // namespace
+
 class Mesh::Impl {
 public:
   std::vector<Vertex> vertices;
@@ -21,6 +73,20 @@ public:
 Mesh::Mesh() : pImpl(std::make_unique<Impl>()) {}
 Mesh::~Mesh() = default;
 
+Mesh::Mesh(const Mesh &other) : pImpl(std::make_unique<Impl>()) {
+  pImpl->vertices = other.pImpl->vertices;
+  pImpl->faces = other.pImpl->faces;
+}
+
+Mesh &Mesh::operator=(const Mesh &other) {
+  if (this != &other) {
+    pImpl->vertices = other.pImpl->vertices;
+    pImpl->faces = other.pImpl->faces;
+    pImpl->onGPU = false; // Geometry changed, needs a fresh upload
+  }
+  return *this;
+}
+
 void Mesh::setVertices(std::vector<Vertex> vertices) {
   pImpl->vertices = std::move(vertices);
 }
@@ -141,79 +207,98 @@ std::shared_ptr<Mesh> Mesh::createQuad(float width, float height) {
   return mesh;
 }
 
-std::shared_ptr<Mesh> Mesh::createTShirtTemplate() {
-  auto mesh = std::make_shared<Mesh>();
-
+std::shared_ptr<Mesh> Mesh::createTShirtTemplate(int rows, int cols) {
   // Create a basic T-shirt shaped mesh
   // This is a simplified version - production would use detailed template
-
-  const int rows = 20;
-  const int cols = 15;
-  std::vector<Vertex> vertices;
-
-  for (int r = 0; r < rows; ++r) {
-    float y = 1.0f - (float(r) / (rows - 1)) * 1.5f; // -0.5 to 1.0
-
-    for (int c = 0; c < cols; ++c) {
-      float t = float(c) / (cols - 1);
-      float x = (t - 0.5f) * 0.8f; // -0.4 to 0.4
-
-      // Add sleeve width at shoulder level
-      if (r >= 2 && r <= 5) {
-        float sleeveExtend = 0.3f * (1.0f - std::abs(r - 3.5f) / 2.0f);
-        if (t < 0.3f)
-          x -= sleeveExtend;
-        if (t > 0.7f)
-          x += sleeveExtend;
-      }
-
-      Vertex v;
-      v.position = {x, y, 0.0f};
-      v.normal = {0, 0, 1};
-      v.texCoord = {t, float(r) / (rows - 1)};
-      vertices.push_back(v);
+  auto noSkip = [](int, int) { return false; };
+
+  return buildGridTemplate(rows, cols, [](int, int, float t, float v) {
+    float y = 1.0f - v * 1.5f;    // -0.5 to 1.0
+    float x = (t - 0.5f) * 0.8f;  // -0.4 to 0.4
+
+    // Add sleeve width at shoulder level (rows 2-5 of the 20-row grid)
+    float d = std::abs(v * 19.0f - 3.5f);
+    if (d <= 1.5f + 1e-4f) {
+      float sleeveExtend = 0.3f * (1.0f - d / 2.0f);
+      if (t < 0.3f)
+        x -= sleeveExtend;
+      if (t > 0.7f)
+        x += sleeveExtend;
     }
-  }
+    return Point3D{x, y, 0.0f};
+  }, noSkip);
+}
 
-  std::vector<Face> faces;
-  for (int r = 0; r < rows - 1; ++r) {
-    for (int c = 0; c < cols - 1; ++c) {
-      int i = r * cols + c;
-      faces.push_back({{static_cast<uint32_t>(i), static_cast<uint32_t>(i + 1),
-                        static_cast<uint32_t>(i + cols + 1)}});
-      faces.push_back(
-          {{static_cast<uint32_t>(i), static_cast<uint32_t>(i + cols + 1),
-            static_cast<uint32_t>(i + cols)}});
-    }
-  }
+std::shared_ptr<Mesh> Mesh::createPantsTemplate(int rows, int cols) {
+  // Hip section across the full width, splitting into two legs below the
+  // crotch. Each leg takes half of the columns; the quads between the two
+  // middle columns are left open below the crotch.
+  const float crotch = 0.3f; // Fraction of the height where the legs split
+  cols = std::max(cols + (cols & 1), 4);
+  const int half = cols / 2;
+  rows = std::max(rows, 2);
+  const int lastRow = rows - 1;
+
+  return buildGridTemplate(rows, cols, [&](int, int c, float t, float v) {
+    float y = 1.0f - v * 1.5f;         // -0.5 to 1.0
+    float hipX = (t - 0.5f) * 0.7f;    // -0.35 to 0.35
+    if (v <= crotch) return Point3D{hipX, y, 0.0f};
+
+    // Leg: u runs from the outer seam (0) to the inner seam (1), legs taper
+    float s = (v - crotch) / (1.0f - crotch);
+    int k = c < half ? c : cols - 1 - c;
+    float u = float(k) / (half - 1);
+    float outer = 0.35f - 0.08f * s;
+    float inner = 0.03f + 0.02f * s;
+    float legX = (c < half ? -1.0f : 1.0f) * (outer + (inner - outer) * u);
+    float blend = std::min(1.0f, s * 3.0f);
+    return Point3D{hipX + (legX - hipX) * blend, y, 0.0f};
+  }, [&](int r, int c) { return c == half - 1 && float(r) / lastRow >= crotch - 1e-4f; });
+}
 
-  mesh->setVertices(vertices);
-  mesh->setFaces(faces);
-  mesh->calculateNormals();
+std::shared_ptr<Mesh> Mesh::createDressTemplate(int rows, int cols) {
+  // Fitted bodice narrowing to the waist, then a skirt flaring to the hem
+  const float waist = 0.3f;
+  auto noSkip = [](int, int) { return false; };
+
+  return buildGridTemplate(rows, cols, [&](int, int, float t, float v) {
+    float y = 1.0f - v * 1.5f; // -0.5 to 1.0
+    float halfWidth = v <= waist ? 0.30f + (0.24f - 0.30f) * (v / waist)
+                                 : 0.24f + (0.48f - 0.24f) * ((v - waist) / (1.0f - waist));
+    return Point3D{(t - 0.5f) * 2.0f * halfWidth, y, 0.0f};
+  }, noSkip);
+}
 
-  return mesh;
+int Mesh::templateLevel(float resolution) {
+  float r = std::clamp(resolution, 0.0f, 1.0f);
+  return static_cast<int>(std::lround(r * (MESH_TEMPLATE_LEVEL_COUNT - 1)));
 }
 
-std::shared_ptr<Mesh> Mesh::createFromType(GarmentType type) {
+std::shared_ptr<Mesh> Mesh::createTemplate(GarmentType type, const MeshTemplateLevel &level) {
   switch (type) {
   case GarmentType::TSHIRT:
   case GarmentType::SHIRT:
-    return createTShirtTemplate();
+  case GarmentType::JACKET:
+  case GarmentType::COAT:
+    return createTShirtTemplate(level.rows, level.cols);
 
   case GarmentType::PANTS:
   case GarmentType::SHORTS:
-    // TODO: Create pants template
-    return createQuad(0.8f, 1.0f);
+    return createPantsTemplate(level.rows, level.cols);
 
   case GarmentType::DRESS:
-    // TODO: Create dress template
-    return createTShirtTemplate();
+  case GarmentType::SKIRT:
+    return createDressTemplate(level.rows, level.cols);
 
   default:
     return createQuad(1.0f, 1.0f);
   }
 }
 
+std::shared_ptr<Mesh> Mesh::createFromType(GarmentType type, float resolution) {
+  return createTemplate(type, MESH_TEMPLATE_LEVELS[templateLevel(resolution)]);
+}
+
 Mesh::BoundingBox Mesh::getBoundingBox() const {
   BoundingBox box;
   box.min = {FLT_MAX, FLT_MAX, FLT_MAX};
@@ -4,11 +4,14 @@
  */
 
 #include "physics_engine.h"
+#include "sparse_cholesky.h"
+#include "thread_pool.h"
 #include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <map>
 #include <set>
+#include <unordered_map>
 
 namespace arfit {
 
@@ -23,6 +26,66 @@ struct Particle {
   int anchorBoneId = -1; // 追従するボーンID (-1はなし)
 };
 
+/**
+ * @brief 粒子の空間ハッシュグリッド（毎フレーム再構築、再確保なし）
+ */
+struct SpatialGrid {
+  float cellSize = 0.02f;
+  std::vector<int> cellStart; // テーブルサイズ + 1
+  std::vector<int> entries;   // セル順に並べた粒子インデックス
+  std::vector<int> particleCell;
+
+  int cellCoord(float v) const { return (int)std::floor(v / cellSize); }
+
+  size_t hashCell(int x, int y, int z) const {
+    uint32_t h = (uint32_t)(x * 92837111) ^ (uint32_t)(y * 689287499) ^
+                 (uint32_t)(z * 283923481);
+    return h % (cellStart.size() - 1);
+  }
+
+  /**
+   * 計数ソートでセルごとに粒子を詰める
+   */
+  template <typename Positions>
+  void build(const Positions &positionOf, const std::vector<int> &indices, float size) {
+    cellSize = size;
+    cellStart.assign(2 * indices.size() + 2, 0);
+    entries.resize(indices.size());
+    particleCell.resize(indices.size());
+
+    for (size_t i = 0; i < indices.size(); ++i) {
+      const Point3D &p = positionOf(indices[i]);
+      particleCell[i] = (int)hashCell(cellCoord(p.x), cellCoord(p.y), cellCoord(p.z));
+      cellStart[particleCell[i] + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c) cellStart[c] += cellStart[c - 1];
+    std::vector<int> &fill = particleCell; // 書き込み位置として再利用
+    for (size_t i = 0; i < indices.size(); ++i) {
+      int cell = fill[i];
+      fill[i] = cellStart[cell]++;
+      entries[fill[i]] = indices[i];
+    }
+    // cellStartが1つずれたので戻す
+    for (size_t c = cellStart.size() - 1; c > 0; --c) cellStart[c] = cellStart[c - 1];
+    cellStart[0] = 0;
+  }
+
+  /**
+   * 点の周囲27セルに含まれる粒子を列挙（ハッシュ衝突による余分な候補を含む）
+   */
+  template <typename Fn>
+  void query(const Point3D &p, Fn &&fn) const {
+    if (entries.empty()) return;
+    int cx = cellCoord(p.x), cy = cellCoord(p.y), cz = cellCoord(p.z);
+    for (int dz = -1; dz <= 1; ++dz)
+      for (int dy = -1; dy <= 1; ++dy)
+        for (int dx = -1; dx <= 1; ++dx) {
+          size_t cell = hashCell(cx + dx, cy + dy, cz + dz);
+          for (int e = cellStart[cell]; e < cellStart[cell + 1]; ++e) fn(entries[e]);
+        }
+  }
+};
+
 /**
  * @brief 距離制約（バネ）
  */
@@ -41,15 +104,163 @@ public:
   std::vector<Particle> particles;
   std::vector<Constraint> constraints;
   
-  // 衣服ごとの粒子範囲
-  struct Range { size_t start; size_t count; };
+  // 衣服ごとの粒子範囲とレイヤー（0が最も内側）
+  struct Range {
+    size_t start;
+    size_t count; // 溶接後の粒子数
+    int layer = 0;
+    float avgEdgeLength = 0.02f;
+    std::vector<int> weld; // 描画頂点 -> 範囲内の粒子インデックス
+  };
   std::map<std::shared_ptr<Garment>, Range> garmentMap;
 
+  // レイヤー間衝突用: 面（粒子インデックス）、内側レイヤーの法線とグリッド
+  std::vector<std::array<int, 3>> faces;
+  std::vector<Point3D> particleNormals;
+  std::map<int, SpatialGrid> layerGrids;
+  std::map<int, std::vector<int>> layerParticles;
+
+  // Projective Dynamics: 事前分解済みのシステム行列と作業領域
+  SparseCholesky pdSystem;
+  std::vector<int> pdIndex; // 粒子 -> システム行（-1は固定点）
+  float pdTimeStep = 0.0f;
+  bool pdDirty = true;
+  std::vector<Point3D> pdInertia;
+  std::vector<Point3D> pdProjections;
+  std::vector<Point3D> pdRhs;
+
   // ボディトラッキングから得られた衝突判定用データ
   CollisionBody lastBody;
+  std::vector<Point3D> prevBodyVertices; // 連続衝突判定用の前回の関節位置
+  bool bodyMoved = false;                // 前回のステップ以降に衝突ボディーが更新されたか
+
+  // 事前に落ち着かせたドレープ（初期形状）のキャッシュ
+  std::shared_ptr<DrapeCache> drapeCache;
+  std::array<float, 10> bodyShape{};
 
   Impl() {}
 
+  /**
+   * 衣服メッシュの頂点から粒子と制約を生成して追加
+   */
+  Range appendGarment(std::shared_ptr<Garment> garment) {
+    size_t start = particles.size();
+    const auto& vertices = garment->getMesh()->getVertices();
+
+    Range range{start, 0};
+    range.weld = buildWeldMap(vertices, range.count);
+
+    particles.resize(start + range.count);
+    size_t initializedCount = 0;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+      // 粒子は頂点順に採番されるので、最初に対応した頂点（代表頂点）で初期化
+      if (range.weld[i] != (int)initializedCount) continue;
+      ++initializedCount;
+      Particle &p = particles[start + range.weld[i]];
+
+      p.position = vertices[i].position;
+      p.prevPosition = p.position;
+      p.velocity = {0, 0, 0};
+      p.invMass = 1.0f;
+
+      // Y座標とX座標に基づき、肩をボーンにアンカー
+      if (vertices[i].position.y > 0.45f && std::abs(vertices[i].position.x) > 0.15f) {
+          p.invMass = 0.0f; // 固定
+          p.anchorBoneId = (vertices[i].position.x < 0) ?
+              (int)BodyLandmark::LEFT_SHOULDER : (int)BodyLandmark::RIGHT_SHOULDER;
+      }
+    }
+
+    size_t firstConstraint = constraints.size();
+    createConstraintsFromMesh(garment, range);
+
+    for (const auto& face : garment->getMesh()->getFaces()) {
+      int a = (int)start + range.weld[face.indices[0]];
+      int b = (int)start + range.weld[face.indices[1]];
+      int c = (int)start + range.weld[face.indices[2]];
+      if (a != b && b != c && a != c) faces.push_back({a, b, c});
+    }
+
+    if (constraints.size() > firstConstraint) {
+      float total = 0.0f;
+      for (size_t i = firstConstraint; i < constraints.size(); ++i) total += constraints[i].restLength;
+      range.avgEdgeLength = total / (constraints.size() - firstConstraint);
+    }
+    return range;
+  }
+
+  /**
+   * 位置ハッシュで重複頂点（UVシームなど）を1つの粒子にまとめる
+   * @param uniqueCount 溶接後の粒子数
+   * @return 描画頂点ごとの粒子インデックス
+   */
+  std::vector<int> buildWeldMap(const std::vector<Vertex> &vertices, size_t &uniqueCount) {
+    std::vector<int> weld(vertices.size());
+    uniqueCount = 0;
+    float tol = config.weldTolerance;
+    if (tol <= 0.0f) {
+      for (size_t i = 0; i < vertices.size(); ++i) weld[i] = (int)uniqueCount++;
+      return weld;
+    }
+
+    auto cellKey = [](int x, int y, int z) {
+      return ((uint64_t)(uint32_t)x * 73856093u) ^ ((uint64_t)(uint32_t)y * 19349663u << 21) ^
+             ((uint64_t)(uint32_t)z * 83492791u << 42);
+    };
+    std::unordered_map<uint64_t, std::vector<int>> cells;
+    cells.reserve(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+      const Point3D &p = vertices[i].position;
+      int cx = (int)std::floor(p.x / tol), cy = (int)std::floor(p.y / tol), cz = (int)std::floor(p.z / tol);
+
+      // 近傍27セル内で許容誤差以内の代表頂点を探す
+      int found = -1;
+      for (int dz = -1; dz <= 1 && found < 0; ++dz)
+        for (int dy = -1; dy <= 1 && found < 0; ++dy)
+          for (int dx = -1; dx <= 1 && found < 0; ++dx) {
+            auto it = cells.find(cellKey(cx + dx, cy + dy, cz + dz));
+            if (it == cells.end()) continue;
+            for (int rep : it->second) {
+              Point3D d = vertices[rep].position - p;
+              if (d.x*d.x + d.y*d.y + d.z*d.z <= tol * tol) {
+                found = weld[rep];
+                break;
+              }
+            }
+          }
+
+      if (found >= 0) {
+        weld[i] = found;
+      } else {
+        weld[i] = (int)uniqueCount++;
+        cells[cellKey(cx, cy, cz)].push_back((int)i);
+      }
+    }
+    return weld;
+  }
+
+  /**
+   * キャッシュ済みドレープがあれば粒子の初期位置を置き換える
+   * （制約の静止長はテンプレート形状のまま維持）
+   */
+  void applyCachedDrape(std::shared_ptr<Garment> garment, const Range &range) {
+    if (!drapeCache) return;
+
+    std::vector<Point3D> drape;
+    if (!drapeCache->findNearest(DrapeCache::garmentKey(*garment), bodyShape, drape) ||
+        drape.size() != range.count) {
+      return;
+    }
+
+    for (size_t i = 0; i < range.count; ++i) {
+      Particle &p = particles[range.start + i];
+      p.position = drape[i];
+      p.prevPosition = drape[i];
+      p.velocity = {0, 0, 0};
+    }
+  }
+
   /**
    * 物理状態の更新（メインループ）
    */
@@ -63,6 +274,7 @@ public:
         p.velocity = p.velocity + gravity * dt;
         p.prevPosition = p.position;
         p.position = p.position + p.velocity * dt;
+        if (config.enableContinuousCollision) sweepCollisions(p);
       } else if (p.anchorBoneId != -1 && p.anchorBoneId < lastBody.vertices.size()) {
           // 固定点（肩など）はボディの関節座標に直接追随
           p.prevPosition = p.position;
@@ -70,59 +282,249 @@ public:
       }
     }
 
-    // 2. 制約解消（反復計算）
-    for (int i = 0; i < config.solverIterations; ++i) {
-      // 距離制約（バネの伸縮を解決）
-      for (const auto &c : constraints) {
-        Particle &p1 = particles[c.p1];
-        Particle &p2 = particles[c.p2];
-        
-        Point3D delta = p1.position - p2.position;
-        float dist = std::sqrt(delta.x*delta.x + delta.y*delta.y + delta.z*delta.z);
-        if (dist < 0.0001f) continue;
-        
-        float diff = (dist - c.restLength) / (p1.invMass + p2.invMass + 0.0001f) * c.stiffness;
-        Point3D correction = delta * (diff / dist);
-        
-        if (p1.invMass > 0) p1.position = p1.position - correction * p1.invMass;
-        if (p2.invMass > 0) p2.position = p2.position + correction * p2.invMass;
-      }
-      
-      // 3. 衝突判定と解消
-      solveCollisions();
+    // 内側レイヤーの衝突用グリッドを構築（フレームごとに1回）
+    bool layered = prepareLayerColliders();
+
+    // 2. 制約解消と 3. 衝突判定
+    if (config.solver == ClothSolver::PROJECTIVE_DYNAMICS) {
+      solveProjective(dt, layered);
+    } else {
+      solvePositionBased(layered);
     }
 
+    // 反復回数が少なくても伸びすぎないよう、最後にひずみを制限する
+    if (config.maxStretchRatio > 1.0f) limitStrain();
+
     // 4. 速度の更新（PBDにおける速度計算）
     for (auto &p : particles) {
       if (p.invMass > 0) {
         p.velocity = (p.position - p.prevPosition) * (1.0f / dt) * config.damping;
       }
     }
+
+    // 次ステップの連続衝突判定ではここからの関節の移動を扱う（静止中は同一なので省略）
+    if (bodyMoved) {
+      prevBodyVertices.assign(lastBody.vertices.begin(), lastBody.vertices.end());
+      bodyMoved = false;
+    }
+  }
+
+  /**
+   * 距離制約（バネの伸縮）をGauss-Seidelで解決
+   */
+  void solveDistanceConstraints() {
+    for (const auto &c : constraints) {
+      Particle &p1 = particles[c.p1];
+      Particle &p2 = particles[c.p2];
+
+      Point3D delta = p1.position - p2.position;
+      float dist = std::sqrt(delta.x*delta.x + delta.y*delta.y + delta.z*delta.z);
+      if (dist < 0.0001f) continue;
+
+      float diff = (dist - c.restLength) / (p1.invMass + p2.invMass + 0.0001f) * c.stiffness;
+      Point3D correction = delta * (diff / dist);
+
+      if (p1.invMass > 0) p1.position = p1.position - correction * p1.invMass;
+      if (p2.invMass > 0) p2.position = p2.position + correction * p2.invMass;
+    }
+  }
+
+  /**
+   * PBDによる制約解消（反復ごとに衝突も解消する）
+   */
+  void solvePositionBased(bool layered) {
+    for (int i = 0; i < config.solverIterations; ++i) {
+      solveDistanceConstraints();
+      solveCollisions();
+      if (layered) solveLayerCollisions();
+    }
+  }
+
+  /**
+   * ひずみ制限: 最大伸び率を超えたエッジだけを上限長まで引き戻す
+   */
+  void limitStrain() {
+    for (const auto &c : constraints) {
+      Particle &p1 = particles[c.p1];
+      Particle &p2 = particles[c.p2];
+      float wSum = p1.invMass + p2.invMass;
+      if (wSum <= 0.0f) continue;
+
+      Point3D delta = p1.position - p2.position;
+      float distSq = delta.x*delta.x + delta.y*delta.y + delta.z*delta.z;
+      float maxLength = c.restLength * config.maxStretchRatio;
+      if (distSq <= maxLength * maxLength) continue;
+
+      float dist = std::sqrt(distSq);
+      Point3D correction = delta * ((dist - maxLength) / (dist * wSum));
+      p1.position = p1.position - correction * p1.invMass;
+      p2.position = p2.position + correction * p2.invMass;
+    }
+  }
+
+  /**
+   * Projective Dynamicsのシステム行列 (M/h^2 + Σ w A^T A) を構築して分解
+   *
+   * 固定点（invMass = 0）は未知数から除外し、右辺に移項する。
+   * 行列は時間刻みと制約構成にのみ依存するため、衣服追加時に一度だけ分解する。
+   * M/h^2 + Σ w AᵀA は重みが非負なら対角優位で常に正定値（静止長は右辺にのみ現れる）。
+   * 負の projectiveWeight や剛性で分解に失敗した場合に備え、false を返してPBDで解く。
+   */
+  bool buildProjectiveSystem(float dt) {
+    pdIndex.assign(particles.size(), -1);
+    int n = 0;
+    for (size_t i = 0; i < particles.size(); ++i) {
+      if (particles[i].invMass > 0) pdIndex[i] = n++;
+    }
+
+    std::vector<SparseCholesky::Entry> entries;
+    entries.reserve(n + constraints.size() * 3);
+    float inertia = 1.0f / (dt * dt);
+    for (size_t i = 0; i < particles.size(); ++i) {
+      if (pdIndex[i] >= 0) entries.push_back({pdIndex[i], pdIndex[i], inertia / particles[i].invMass});
+    }
+    for (const auto &c : constraints) {
+      float w = c.stiffness * config.projectiveWeight;
+      int a = pdIndex[c.p1], b = pdIndex[c.p2];
+      if (a >= 0) entries.push_back({a, a, w});
+      if (b >= 0) entries.push_back({b, b, w});
+      if (a >= 0 && b >= 0) entries.push_back({std::max(a, b), std::min(a, b), -w});
+    }
+
+    // 失敗しても次に制約構成か時間刻みが変わるまでは再分解しない
+    bool factored = pdSystem.factor(n, entries);
+    pdTimeStep = dt;
+    pdDirty = false;
+    return factored;
+  }
+
+  /**
+   * Projective Dynamicsによる制約解消
+   * ローカルステップ（各制約の射影）は並列、グローバルステップは前進・後退代入のみ
+   */
+  void solveProjective(float dt, bool layered) {
+    if (pdDirty || dt != pdTimeStep) buildProjectiveSystem(dt);
+    if (!pdSystem.isFactored()) {
+      // 分解できない系ではPBDに切り替える（衝突解消は省かない）
+      solvePositionBased(layered);
+      return;
+    }
+
+    // 慣性項 M/h^2 * s（sは予測位置）
+    int n = pdSystem.dimension();
+    float inertia = 1.0f / (dt * dt);
+    pdInertia.resize(n);
+    for (size_t i = 0; i < particles.size(); ++i) {
+      if (pdIndex[i] >= 0) {
+        pdInertia[pdIndex[i]] = particles[i].position * (inertia / particles[i].invMass);
+      }
+    }
+    pdProjections.resize(constraints.size());
+
+    for (int iter = 0; iter < config.solverIterations; ++iter) {
+      // ローカルステップ: 各エッジを静止長に射影
+      ThreadPool::shared().parallelFor(0, constraints.size(), 512, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const Constraint &c = constraints[i];
+          Point3D d = particles[c.p1].position - particles[c.p2].position;
+          float len = std::sqrt(d.x*d.x + d.y*d.y + d.z*d.z);
+          pdProjections[i] = len > 1e-6f ? d * (c.restLength / len) : d;
+        }
+      });
+
+      // グローバルステップ: 右辺を組み立てて事前分解済みの系を解く
+      pdRhs = pdInertia;
+      for (size_t i = 0; i < constraints.size(); ++i) {
+        const Constraint &c = constraints[i];
+        float w = c.stiffness * config.projectiveWeight;
+        int a = pdIndex[c.p1], b = pdIndex[c.p2];
+        Point3D proj = pdProjections[i] * w;
+        if (a >= 0) {
+          pdRhs[a] = pdRhs[a] + proj;
+          if (b < 0) pdRhs[a] = pdRhs[a] + particles[c.p2].position * w;
+        }
+        if (b >= 0) {
+          pdRhs[b] = pdRhs[b] - proj;
+          if (a < 0) pdRhs[b] = pdRhs[b] + particles[c.p1].position * w;
+        }
+      }
+      pdSystem.solve(pdRhs);
+
+      for (size_t i = 0; i < particles.size(); ++i) {
+        if (pdIndex[i] >= 0) particles[i].position = pdRhs[pdIndex[i]];
+      }
+
+      solveCollisions();
+      if (layered) solveLayerCollisions();
+    }
+  }
+
+  /**
+   * 関節球の半径（ボディの主要な関節を球体として近似）
+   */
+  static float collisionRadius(size_t i) {
+      // ランドマークIDに基づいて半径を調整
+      if (i == (size_t)BodyLandmark::NOSE) return 0.15f;  // 頭
+      if (i == (size_t)BodyLandmark::LEFT_HIP || i == (size_t)BodyLandmark::RIGHT_HIP) return 0.22f; // 胴体
+      return 0.08f; // 腕など
+  }
+
+  /**
+   * 連続衝突判定（予測ステージ）
+   *
+   * 粒子の移動線分と移動する関節球を球の座標系で交差判定し、
+   * 最初の衝突時刻(TOI)で位置を止める。接触点は球と一緒に
+   * ステップ終端まで運ばれるため、速い腕の振りでもすり抜けない。
+   */
+  void sweepCollisions(Particle &p) {
+      const auto &body = lastBody.vertices;
+      bool hasPrev = prevBodyVertices.size() == body.size();
+
+      float firstToi = 2.0f;
+      Point3D contact;
+      for (size_t i = 0; i < body.size(); ++i) {
+          const Point3D &c1 = body[i];
+          const Point3D &c0 = hasPrev ? prevBodyVertices[i] : c1;
+          float limit = collisionRadius(i) + config.collisionMargin;
+
+          // 球から見た相対運動 r(t) = a + (b - a) t
+          Point3D a = p.prevPosition - c0;
+          Point3D d = (p.position - c1) - a;
+          float aa = a.x*a.x + a.y*a.y + a.z*a.z;
+          if (aa <= limit * limit) continue; // 開始時点で内部なら離散判定に任せる
+
+          float dd = d.x*d.x + d.y*d.y + d.z*d.z;
+          if (dd < 1e-12f) continue;
+          float ad = a.x*d.x + a.y*d.y + a.z*d.z;
+          float disc = ad * ad - dd * (aa - limit * limit);
+          if (disc < 0) continue;
+
+          float toi = (-ad - std::sqrt(disc)) / dd;
+          if (toi < 0.0f || toi > 1.0f || toi >= firstToi) continue;
+
+          // 接触点を球に固定したまま終端位置まで移動
+          firstToi = toi;
+          contact = c1 + a + d * toi;
+      }
+
+      if (firstToi <= 1.0f) {
+          p.position = contact;
+          p.velocity = p.velocity * 0.7f;
+      }
   }
 
   /**
    * 人体とのリアルな衝突判定（球体モデル）
    */
   void solveCollisions() {
-      // ボディの主要な関節を球体として近似
-      float headRadius = 0.15f;
-      float armRadius = 0.08f;
-      float torsoRadius = 0.22f;
-
       for (auto &p : particles) {
           if (p.invMass <= 0) continue;
           
           for (size_t i = 0; i < lastBody.vertices.size(); ++i) {
               const auto& bv = lastBody.vertices[i];
-              float radius = armRadius;
-              
-              // ランドマークIDに基づいて半径を調整
-              if (i == (int)BodyLandmark::NOSE) radius = headRadius;
-              if (i == (int)BodyLandmark::LEFT_HIP || i == (int)BodyLandmark::RIGHT_HIP) radius = torsoRadius;
-
               Point3D diff = p.position - bv;
               float distSq = diff.x*diff.x + diff.y*diff.y + diff.z*diff.z;
-              float limit = radius + config.collisionMargin;
+              float limit = collisionRadius(i) + config.collisionMargin;
               
               if (distSq < limit * limit) {
                   float dist = std::sqrt(distSq);
@@ -136,18 +538,117 @@ public:
       }
   }
 
+  /**
+   * 内側レイヤーの法線計算と空間グリッド構築
+   * @return 複数レイヤーが存在し、レイヤー間衝突が必要な場合true
+   */
+  bool prepareLayerColliders() {
+    int maxLayer = 0, minLayer = 0;
+    bool first = true;
+    for (const auto &entry : garmentMap) {
+      int layer = entry.second.layer;
+      maxLayer = first ? layer : std::max(maxLayer, layer);
+      minLayer = first ? layer : std::min(minLayer, layer);
+      first = false;
+    }
+    if (first || maxLayer == minLayer) return false;
+
+    // 面法線を累積して粒子法線を求める
+    particleNormals.assign(particles.size(), {0, 0, 0});
+    for (const auto &f : faces) {
+      Point3D e1 = particles[f[1]].position - particles[f[0]].position;
+      Point3D e2 = particles[f[2]].position - particles[f[0]].position;
+      Point3D n = {e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z,
+                   e1.x * e2.y - e1.y * e2.x};
+      for (int k = 0; k < 3; ++k) particleNormals[f[k]] = particleNormals[f[k]] + n;
+    }
+
+    // 法線は体の中心から外向きに揃える
+    Point3D bodyCenter = {0, 0, 0};
+    for (const auto &v : lastBody.vertices) bodyCenter = bodyCenter + v;
+    if (!lastBody.vertices.empty()) bodyCenter = bodyCenter * (1.0f / lastBody.vertices.size());
+
+    for (auto &list : layerParticles) list.second.clear();
+    std::map<int, float> cellSizes;
+    for (const auto &entry : garmentMap) {
+      const Range &r = entry.second;
+      if (r.layer == maxLayer) continue; // 最外層はコライダーにならない
+
+      auto &list = layerParticles[r.layer];
+      for (size_t i = r.start; i < r.start + r.count; ++i) {
+        Point3D &n = particleNormals[i];
+        float len = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+        if (len < 1e-8f) continue;
+        n = n * (1.0f / len);
+        Point3D out = particles[i].position - bodyCenter;
+        if (n.x * out.x + n.y * out.y + n.z * out.z < 0) n = n * -1.0f;
+        list.push_back((int)i);
+      }
+      float &size = cellSizes[r.layer];
+      size = std::max({size, r.avgEdgeLength, 2.0f * config.layerThickness});
+    }
+
+    for (const auto &entry : cellSizes) {
+      layerGrids[entry.first].build(
+          [this](int i) -> const Point3D & { return particles[i].position; },
+          layerParticles[entry.first], entry.second);
+    }
+    return true;
+  }
+
+  /**
+   * 外側レイヤーの粒子を、厚み分膨らませた内側レイヤー表面の外へ押し出す
+   */
+  void solveLayerCollisions() {
+    for (const auto &entry : garmentMap) {
+      const Range &r = entry.second;
+
+      for (auto gridIt = layerGrids.begin(); gridIt != layerGrids.end(); ++gridIt) {
+        if (gridIt->first >= r.layer || layerParticles[gridIt->first].empty()) continue;
+        const SpatialGrid &grid = gridIt->second;
+        float radiusSq = grid.cellSize * grid.cellSize;
+
+        for (size_t i = r.start; i < r.start + r.count; ++i) {
+          Particle &p = particles[i];
+          if (p.invMass <= 0) continue;
+
+          // 最も近い内側粒子を探す
+          int nearest = -1;
+          float nearestSq = radiusSq;
+          grid.query(p.position, [&](int j) {
+            Point3D d = p.position - particles[j].position;
+            float distSq = d.x * d.x + d.y * d.y + d.z * d.z;
+            if (distSq < nearestSq) {
+              nearestSq = distSq;
+              nearest = j;
+            }
+          });
+          if (nearest < 0) continue;
+
+          const Point3D &n = particleNormals[nearest];
+          Point3D d = p.position - particles[nearest].position;
+          float height = d.x * n.x + d.y * n.y + d.z * n.z;
+          if (height < config.layerThickness) {
+            p.position = p.position + n * (config.layerThickness - height);
+          }
+        }
+      }
+    }
+  }
+
   /**
    * メッシュのエッジ情報からストレッチ・ベンディング制約を生成
    */
-  void createConstraintsFromMesh(std::shared_ptr<Garment> garment, size_t startOffset) {
+  void createConstraintsFromMesh(std::shared_ptr<Garment> garment, const Range &range) {
     const auto& faces = garment->getMesh()->getFaces();
     std::set<std::pair<int, int>> edges;
 
-    // ストレッチ制約（面を構成する3辺）
+    // ストレッチ制約（面を構成する3辺、溶接済みの粒子間のみ）
     for (const auto& face : faces) {
       for (int i = 0; i < 3; ++i) {
-        int a = (int)(startOffset + face.indices[i]);
-        int b = (int)(startOffset + face.indices[(i + 1) % 3]);
+        int a = (int)range.start + range.weld[face.indices[i]];
+        int b = (int)range.start + range.weld[face.indices[(i + 1) % 3]];
+        if (a == b) continue;
         if (a > b) std::swap(a, b);
         
         if (edges.find({a, b}) == edges.end()) {
@@ -173,37 +674,69 @@ Result<void> PhysicsEngine::initialize(const PhysicsConfig &config) {
   return {.error = ErrorCode::SUCCESS};
 }
 
-Result<void> PhysicsEngine::addGarment(std::shared_ptr<Garment> garment) {
+Result<void> PhysicsEngine::addGarment(std::shared_ptr<Garment> garment, int layer) {
   if (!garment || !garment->getMesh()) return {.error = ErrorCode::INVALID_IMAGE};
 
-  size_t start = pImpl->particles.size();
-  const auto& vertices = garment->getMesh()->getVertices();
-  
-  for (size_t i = 0; i < vertices.size(); ++i) {
-    Particle p;
-    p.position = vertices[i].position;
-    p.prevPosition = p.position;
-    p.velocity = {0, 0, 0};
-    p.invMass = 1.0f;
-    
-    // Y座標とX座標に基づき、肩をボーンにアンカー
-    if (vertices[i].position.y > 0.45f && std::abs(vertices[i].position.x) > 0.15f) {
-        p.invMass = 0.0f; // 固定
-        p.anchorBoneId = (vertices[i].position.x < 0) ? 
-            (int)BodyLandmark::LEFT_SHOULDER : (int)BodyLandmark::RIGHT_SHOULDER;
-    }
-    
-    pImpl->particles.push_back(p);
-  }
-
-  pImpl->createConstraintsFromMesh(garment, start);
-  pImpl->garmentMap[garment] = {start, vertices.size()};
+  if (layer < 0) {
+    layer = 0;
+    for (const auto &entry : pImpl->garmentMap) {
+      layer = std::max(layer, entry.second.layer + 1);
+    }
+  }
+
+  auto range = pImpl->appendGarment(garment);
+  range.layer = layer;
+
+  // Projective Dynamicsではシステム行列をここで事前分解する
+  pImpl->pdDirty = true;
+  if (pImpl->config.solver == ClothSolver::PROJECTIVE_DYNAMICS) {
+    pImpl->buildProjectiveSystem(pImpl->config.timeStep);
+  }
+  pImpl->applyCachedDrape(garment, range);
+  pImpl->garmentMap[garment] = range;
   
   return {.error = ErrorCode::SUCCESS};
 }
 
+void PhysicsEngine::setDrapeCache(std::shared_ptr<DrapeCache> cache) {
+  pImpl->drapeCache = std::move(cache);
+}
+
+void PhysicsEngine::setBodyShape(const std::array<float, 10> &betas) {
+  pImpl->bodyShape = betas;
+}
+
+Result<void> PhysicsEngine::bakeDrape(std::shared_ptr<Garment> garment,
+                                      const CollisionBody &canonicalBody,
+                                      const std::array<float, 10> &betas,
+                                      const PhysicsConfig &config,
+                                      int settleSteps) {
+  auto cache = pImpl->drapeCache;
+  if (!cache || !cache->isInitialized()) {
+    return {.error = ErrorCode::INITIALIZATION_FAILED,
+            .message = "Drape cache not set"};
+  }
+  if (!garment || !garment->getMesh()) return {.error = ErrorCode::INVALID_IMAGE};
+
+  // ライブのシミュレーションとは独立した状態で落ち着かせる
+  Impl sim;
+  sim.config = config;
+  sim.lastBody = canonicalBody;
+  auto range = sim.appendGarment(garment);
+  for (int i = 0; i < settleSteps; ++i) {
+    sim.update(sim.config.timeStep);
+  }
+
+  std::vector<Point3D> drape(range.count);
+  for (size_t i = 0; i < range.count; ++i) {
+    drape[i] = sim.particles[range.start + i].position;
+  }
+  return cache->store(DrapeCache::garmentKey(*garment), cache->quantize(betas), drape);
+}
+
 void PhysicsEngine::updateCollisionBody(const CollisionBody &body) {
   pImpl->lastBody = body;
+  pImpl->bodyMoved = true;
 }
 
 Result<PhysicsResult> PhysicsEngine::step(float dt) {
@@ -217,8 +750,11 @@ std::vector<Point3D> PhysicsEngine::getParticlePositions(std::shared_ptr<Garment
   std::vector<Point3D> pos;
   auto it = pImpl->garmentMap.find(garment);
   if (it != pImpl->garmentMap.end()) {
-    for (size_t i = 0; i < it->second.count; ++i) {
-      pos.push_back(pImpl->particles[it->second.start + i].position);
+    // 溶接された粒子を描画頂点へ展開
+    const auto &range = it->second;
+    pos.resize(range.weld.size());
+    for (size_t i = 0; i < range.weld.size(); ++i) {
+      pos[i] = pImpl->particles[range.start + range.weld[i]].position;
     }
   }
   return pos;
@@ -231,7 +767,9 @@ void PhysicsEngine::removeGarment(std::shared_ptr<Garment> garment) {
 void PhysicsEngine::reset() {
   pImpl->particles.clear();
   pImpl->constraints.clear();
+  pImpl->faces.clear();
   pImpl->garmentMap.clear();
+  pImpl->pdDirty = true;
 }
 
 bool PhysicsEngine::isInitialized() const { return pImpl->initialized; }
@@ -0,0 +1,143 @@
+/**
+ * @file pose_estimator.cpp
+ * @brief CPU参照用の姿勢推定バックエンド
+ *
+ * 入力テンソルを2面持ち、呼び出し側が一方に書き込む間にワーカースレッドが
+ * もう一方で推論を行います。
+ */
+
+#include "pose_estimator.h"
+#include "pose_input_slots.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace arfit {
+
+class ReferencePoseEstimator::Impl {
+public:
+  using SlotState = PoseInputSlots::SlotState;
+
+  PoseEstimatorConfig config;
+  PoseInputSlots slots;
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  bool stopping = false;
+  std::thread worker;
+
+  explicit Impl(const PoseEstimatorConfig &cfg) : config(cfg), slots(cfg) {
+    worker = std::thread([this] { workerLoop(); });
+  }
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    changed.notify_all();
+    worker.join();
+  }
+
+  void workerLoop() {
+    for (;;) {
+      PoseInputSlots::Slot *slot = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        // 投入順（チケットの小さい順）に処理する
+        changed.wait(lock, [&] {
+          if (stopping) return true;
+          slot = slots.nextQueued();
+          return slot != nullptr;
+        });
+        if (stopping) return;
+        slot->state = SlotState::RUNNING;
+      }
+
+      // ロック外で推論（呼び出し側はもう一方のバッファに書き込める）
+      std::vector<BodyPose> poses;
+      infer(slot->tensor, config.maxPoses, poses);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        slot->poses = std::move(poses);
+        slot->state = SlotState::DONE;
+      }
+      changed.notify_all();
+    }
+  }
+};
+
+ReferencePoseEstimator::ReferencePoseEstimator(const PoseEstimatorConfig &config)
+    : pImpl(std::make_unique<Impl>(config)) {}
+
+ReferencePoseEstimator::~ReferencePoseEstimator() = default;
+
+int ReferencePoseEstimator::inputWidth() const { return pImpl->config.inputWidth; }
+int ReferencePoseEstimator::inputHeight() const { return pImpl->config.inputHeight; }
+
+PoseInputTensor &ReferencePoseEstimator::acquireInput() {
+  std::unique_lock<std::mutex> lock(pImpl->mutex);
+  return pImpl->slots.acquire(lock, pImpl->changed);
+}
+
+uint64_t ReferencePoseEstimator::submit() {
+  uint64_t ticket;
+  {
+    std::lock_guard<std::mutex> lock(pImpl->mutex);
+    ticket = pImpl->slots.submit().ticket;
+  }
+  pImpl->changed.notify_all();
+  return ticket;
+}
+
+bool ReferencePoseEstimator::poll(uint64_t ticket, std::vector<BodyPose> &poses) {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  return pImpl->slots.poll(ticket, poses);
+}
+
+bool ReferencePoseEstimator::wait(uint64_t ticket, std::vector<BodyPose> &poses) {
+  std::unique_lock<std::mutex> lock(pImpl->mutex);
+  return pImpl->slots.wait(lock, pImpl->changed, ticket, poses);
+}
+
+void ReferencePoseEstimator::infer(const PoseInputTensor &input, int maxPoses,
+                                   std::vector<BodyPose> &poses) {
+  // ※ 実機では ARKit(iOS) / ARCore(Android) / MediaPipe からの
+  //   スケルトンデータを直接受け取るか、このインターフェースの別実装で推論する。
+  //   ここでは入力時刻のみに依存する決定的なデモデータを生成する。
+  int numPeople = std::max(maxPoses, 1);
+  poses.resize(numPeople);
+  for (int p = 0; p < numPeople; ++p) {
+    BodyPose &pose = poses[p];
+    pose = BodyPose{};
+    float sway = std::sin(input.timestamp * 2.0f + p) * 0.05f;
+    float offset = (p - (numPeople - 1) * 0.5f) * 0.9f; // 人物ごとに横にずらす
+
+    // 主要ランドマークの配置（正規化座標: 画面の中央が原点）
+    pose.landmarks[0]  = {offset + 0.0f + sway, -0.8f, 0.0f};    // NOSE
+    pose.landmarks[11] = {offset - 0.2f + sway, -0.5f, 0.0f};    // LEFT_SHOULDER
+    pose.landmarks[12] = {offset + 0.2f + sway, -0.5f, 0.0f};    // RIGHT_SHOULDER
+    pose.landmarks[13] = {offset - 0.35f + sway, -0.2f, 0.05f};  // LEFT_ELBOW
+    pose.landmarks[14] = {offset + 0.35f + sway, -0.2f, 0.05f};  // RIGHT_ELBOW
+    pose.landmarks[15] = {offset - 0.4f, 0.0f, 0.1f};            // LEFT_WRIST
+    pose.landmarks[16] = {offset + 0.4f, 0.0f, 0.1f};            // RIGHT_WRIST
+    pose.landmarks[23] = {offset - 0.12f, 0.1f, 0.0f};           // LEFT_HIP
+    pose.landmarks[24] = {offset + 0.12f, 0.1f, 0.0f};           // RIGHT_HIP
+    pose.landmarks[25] = {offset - 0.15f, 0.5f, 0.0f};           // LEFT_KNEE
+    pose.landmarks[26] = {offset + 0.15f, 0.5f, 0.0f};           // RIGHT_KNEE
+
+    // 信頼度の設定
+    pose.visibility.fill(0.95f);
+    pose.confidence = 0.98f;
+
+    // 出力はテンソル座標系
+    if (input.transform.sourceWidth > 0 && input.transform.sourceHeight > 0) {
+      for (auto &landmark : pose.landmarks) landmark = input.transform.frameToTensor(landmark);
+    }
+  }
+}
+
+} // namespace arfit
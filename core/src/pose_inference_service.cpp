@@ -0,0 +1,191 @@
+/**
+ * @file pose_inference_service.cpp
+ * @brief セッション横断のマイクロバッチ推論サービス
+ *
+ * 各セッションの入力テンソルを1つのキューに集め、バッチが埋まるか
+ * 最古の要求の待ち時間が上限に達した時点でまとめて推論します。
+ */
+
+#include "pose_inference_service.h"
+#include "pose_input_slots.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace arfit {
+
+void ReferenceBatchPoseModel::inferBatch(const std::vector<const PoseInputTensor *> &inputs, int maxPoses,
+                                         std::vector<std::vector<BodyPose>> &outputs) {
+  outputs.resize(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    ReferencePoseEstimator::infer(*inputs[i], maxPoses, outputs[i]);
+  }
+}
+
+class PoseInferenceService::Impl {
+public:
+  struct Request {
+    std::shared_ptr<PoseInputSlots> session; // 推論中にセッションが破棄されても保持
+    PoseInputSlots::Slot *slot;
+    std::chrono::steady_clock::time_point enqueued;
+  };
+
+  PoseInferenceServiceConfig config;
+  std::shared_ptr<IBatchPoseModel> model;
+
+  // キュー・全セッションのスロット状態はこのミューテックスで保護
+  std::mutex mutex;
+  std::condition_variable queued;  // ワーカー向け
+  std::condition_variable changed; // セッション向け
+  std::deque<Request> queue;
+  bool stopping = false;
+  std::thread worker;
+
+  PoseInferenceStats stats;
+
+  Impl(const PoseInferenceServiceConfig &cfg, std::shared_ptr<IBatchPoseModel> batchModel)
+      : config(cfg), model(std::move(batchModel)) {
+    if (!model) model = std::make_shared<ReferenceBatchPoseModel>();
+    config.maxBatchSize = std::max(config.maxBatchSize, 1);
+  }
+
+  void start() {
+    worker = std::thread([this] { workerLoop(); });
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+      // 未処理の要求は結果なしで完了させ、待機中のセッションを起こす
+      for (auto &request : queue) {
+        request.slot->poses.clear();
+        request.slot->state = PoseInputSlots::SlotState::DONE;
+      }
+      queue.clear();
+    }
+    queued.notify_all();
+    changed.notify_all();
+    if (worker.joinable()) worker.join();
+  }
+
+  void workerLoop() {
+    std::vector<Request> batch;
+    std::vector<const PoseInputTensor *> inputs;
+    std::vector<std::vector<BodyPose>> outputs;
+
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        queued.wait(lock, [&] { return stopping || !queue.empty(); });
+        if (stopping) return;
+
+        // 最古の要求の締め切りまで、バッチが埋まるのを待つ
+        auto deadline = queue.front().enqueued +
+                        std::chrono::microseconds((int64_t)(config.maxBatchDelayMs * 1000.0f));
+        queued.wait_until(lock, deadline, [&] {
+          return stopping || (int)queue.size() >= config.maxBatchSize;
+        });
+        if (stopping) return;
+
+        size_t count = std::min(queue.size(), (size_t)config.maxBatchSize);
+        batch.assign(queue.begin(), queue.begin() + count);
+        queue.erase(queue.begin(), queue.begin() + count);
+        for (auto &request : batch) request.slot->state = PoseInputSlots::SlotState::RUNNING;
+
+        stats.requests += count;
+        stats.batches += 1;
+        stats.meanBatchSize = (float)stats.requests / stats.batches;
+      }
+
+      // ロック外でまとめて推論（各セッションはもう一方のバッファに書き込める）
+      inputs.clear();
+      for (auto &request : batch) inputs.push_back(&request.slot->tensor);
+      model->inferBatch(inputs, config.estimator.maxPoses, outputs);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < batch.size(); ++i) {
+          batch[i].slot->poses = i < outputs.size() ? std::move(outputs[i]) : std::vector<BodyPose>{};
+          batch[i].slot->state = PoseInputSlots::SlotState::DONE;
+        }
+      }
+      batch.clear();
+      changed.notify_all();
+    }
+  }
+};
+
+/**
+ * @brief サービスに推論を委ねるセッション側の推定器
+ */
+class PoseInferenceService::Session : public IPoseEstimator {
+public:
+  explicit Session(std::shared_ptr<PoseInferenceService::Impl> service)
+      : service(std::move(service)),
+        state(std::make_shared<PoseInputSlots>(this->service->config.estimator)) {}
+
+  // キュー上の要求がスロットを共有所有するため、推論中でも待たずに破棄できる
+  ~Session() override = default;
+
+  int inputWidth() const override { return service->config.estimator.inputWidth; }
+  int inputHeight() const override { return service->config.estimator.inputHeight; }
+
+  PoseInputTensor &acquireInput() override {
+    std::unique_lock<std::mutex> lock(service->mutex);
+    return state->acquire(lock, service->changed);
+  }
+
+  uint64_t submit() override {
+    uint64_t ticket;
+    {
+      std::lock_guard<std::mutex> lock(service->mutex);
+      PoseInputSlots::Slot &slot = state->submit();
+      ticket = slot.ticket;
+      if (service->stopping) {
+        slot.poses.clear();
+        slot.state = PoseInputSlots::SlotState::DONE;
+        return ticket;
+      }
+      service->queue.push_back({state, &slot, std::chrono::steady_clock::now()});
+    }
+    service->queued.notify_one();
+    return ticket;
+  }
+
+  bool poll(uint64_t ticket, std::vector<BodyPose> &poses) override {
+    std::lock_guard<std::mutex> lock(service->mutex);
+    return state->poll(ticket, poses);
+  }
+
+  bool wait(uint64_t ticket, std::vector<BodyPose> &poses) override {
+    std::unique_lock<std::mutex> lock(service->mutex);
+    return state->wait(lock, service->changed, ticket, poses);
+  }
+
+private:
+  std::shared_ptr<PoseInferenceService::Impl> service;
+  std::shared_ptr<PoseInputSlots> state;
+};
+
+PoseInferenceService::PoseInferenceService(const PoseInferenceServiceConfig &config,
+                                           std::shared_ptr<IBatchPoseModel> model)
+    : pImpl(std::make_shared<Impl>(config, std::move(model))) {
+  pImpl->start();
+}
+
+PoseInferenceService::~PoseInferenceService() { pImpl->stop(); }
+
+std::shared_ptr<IPoseEstimator> PoseInferenceService::createSession() {
+  return std::make_shared<Session>(pImpl);
+}
+
+PoseInferenceStats PoseInferenceService::getStats() const {
+  std::lock_guard<std::mutex> lock(pImpl->mutex);
+  return pImpl->stats;
+}
+
+} // namespace arfit
@@ -0,0 +1,123 @@
+/**
+ * @file pose_input_slots.h
+ * @brief Double-buffered input tensors and per-ticket results behind IPoseEstimator (internal)
+ */
+
+#pragma once
+
+#include "pose_estimator.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace arfit {
+
+/**
+ * @brief Slot state machine shared by the IPoseEstimator backends
+ *
+ * Each of the two slots goes FREE -> FILLING (acquire) -> QUEUED (submit)
+ * -> RUNNING -> DONE, and is refilled once the caller acquires it again.
+ * The owner supplies the mutex guarding the slots and the condition
+ * variable notified on every state change; every member must be called
+ * with that mutex held.
+ */
+class PoseInputSlots {
+public:
+  enum class SlotState { FREE, FILLING, QUEUED, RUNNING, DONE };
+
+  struct Slot {
+    PoseInputTensor tensor;
+    SlotState state = SlotState::FREE;
+    uint64_t ticket = 0;
+    std::vector<BodyPose> poses;
+  };
+
+  explicit PoseInputSlots(const PoseEstimatorConfig &config) {
+    size_t elements = (size_t)config.inputWidth * config.inputHeight * 3;
+    for (auto &slot : slots) {
+      slot.tensor.format = config.inputFormat;
+      slot.tensor.width = config.inputWidth;
+      slot.tensor.height = config.inputHeight;
+      if (config.inputFormat == PoseTensorFormat::FLOAT32) {
+        slot.tensor.data.assign(elements, 0.0f);
+      } else {
+        slot.tensor.bytes.assign(elements, 0);
+      }
+    }
+  }
+
+  /**
+   * @brief Wait until the write slot is no longer being inferred, then start filling it
+   */
+  PoseInputTensor &acquire(std::unique_lock<std::mutex> &lock, std::condition_variable &changed) {
+    Slot &slot = slots[writeSlot];
+    changed.wait(lock, [&] { return slot.state != SlotState::QUEUED && slot.state != SlotState::RUNNING; });
+    slot.state = SlotState::FILLING;
+    return slot.tensor;
+  }
+
+  /**
+   * @brief Queue the write slot under a new ticket and switch to the other slot
+   */
+  Slot &submit() {
+    Slot &slot = slots[writeSlot];
+    slot.ticket = ++nextTicket;
+    slot.state = SlotState::QUEUED;
+    writeSlot ^= 1;
+    return slot;
+  }
+
+  /**
+   * @brief Copy the results of a finished submission
+   */
+  bool poll(uint64_t ticket, std::vector<BodyPose> &poses) {
+    Slot *slot = findSlot(ticket);
+    if (!slot || slot->state != SlotState::DONE) return false;
+    poses = slot->poses;
+    return true;
+  }
+
+  /**
+   * @brief Block until the submission finishes and copy its results
+   * @return false if the ticket is unknown or its slot has been refilled
+   */
+  bool wait(std::unique_lock<std::mutex> &lock, std::condition_variable &changed, uint64_t ticket,
+            std::vector<BodyPose> &poses) {
+    Slot *slot = nullptr;
+    changed.wait(lock, [&] {
+      slot = findSlot(ticket);
+      return !slot || slot->state == SlotState::DONE;
+    });
+    if (!slot) return false;
+    poses = slot->poses;
+    return true;
+  }
+
+  /**
+   * @brief Oldest queued slot (lowest ticket), or nullptr
+   */
+  Slot *nextQueued() {
+    Slot *next = nullptr;
+    for (auto &slot : slots) {
+      if (slot.state == SlotState::QUEUED && (!next || slot.ticket < next->ticket)) next = &slot;
+    }
+    return next;
+  }
+
+private:
+  Slot slots[2];
+  int writeSlot = 0;
+  uint64_t nextTicket = 0;
+
+  Slot *findSlot(uint64_t ticket) {
+    for (auto &slot : slots) {
+      if (slot.ticket == ticket && slot.state != SlotState::FREE && slot.state != SlotState::FILLING) {
+        return &slot;
+      }
+    }
+    return nullptr;
+  }
+};
+
+} // namespace arfit
@@ -0,0 +1,153 @@
+/**
+ * @file pose_predictor.cpp
+ * @brief 表示時刻への姿勢予測（等加速度モデル）
+ */
+
+#include "pose_predictor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace arfit {
+
+namespace {
+
+const int NUM_LANDMARKS = 33;
+
+// 予測するチャンネル: ランドマーク(33x3) + SMPL関節回転(72) + 平行移動(3) + スケール(1)
+const int LANDMARK_CHANNELS = NUM_LANDMARKS * 3;
+const int POSE_OFFSET = LANDMARK_CHANNELS;
+const int TRANSLATION_OFFSET = POSE_OFFSET + 72;
+const int SCALE_OFFSET = TRANSLATION_OFFSET + 3;
+const int NUM_CHANNELS = SCALE_OFFSET + 1;
+
+// 1フレームでこれ以上変化した軸角度は表現の不連続（θ≈πでの反転）とみなす
+const float AXIS_ANGLE_DISCONTINUITY = 1.0f;
+
+} // namespace
+
+class PosePredictor::Impl {
+public:
+  PosePredictorConfig config;
+
+  BodyPose lastPose;
+  SMPLParams lastParams;
+  float lastTimestamp = 0.0f;
+  int numMeasurements = 0;
+
+  std::array<float, NUM_CHANNELS> value{};
+  std::array<float, NUM_CHANNELS> velocity{};
+  std::array<float, NUM_CHANNELS> acceleration{};
+
+  explicit Impl(const PosePredictorConfig &cfg) : config(cfg) {}
+
+  static void pack(const BodyPose &pose, const SMPLParams &params, std::array<float, NUM_CHANNELS> &out) {
+    for (int i = 0; i < NUM_LANDMARKS; ++i) {
+      out[i * 3] = pose.landmarks[i].x;
+      out[i * 3 + 1] = pose.landmarks[i].y;
+      out[i * 3 + 2] = pose.landmarks[i].z;
+    }
+    std::copy(params.pose.begin(), params.pose.end(), out.begin() + POSE_OFFSET);
+    std::copy(params.translation.begin(), params.translation.end(), out.begin() + TRANSLATION_OFFSET);
+    out[SCALE_OFFSET] = params.scale;
+  }
+
+  // 一次ローパスの係数 α = r / (1 + r), r = 2π·fc·dt
+  static float smoothingAlpha(float cutoff, float dt) {
+    float r = 6.28318531f * cutoff * dt;
+    return r / (1.0f + r);
+  }
+};
+
+PosePredictor::PosePredictor(const PosePredictorConfig &config)
+    : pImpl(std::make_unique<Impl>(config)) {}
+
+PosePredictor::~PosePredictor() = default;
+
+void PosePredictor::update(const BodyPose &pose, const SMPLParams &params, float timestamp) {
+  std::array<float, NUM_CHANNELS> current;
+  Impl::pack(pose, params, current);
+
+  float dt = timestamp - pImpl->lastTimestamp;
+  if (pImpl->numMeasurements > 0 && dt > 0.0f) {
+    float alphaV = Impl::smoothingAlpha(pImpl->config.velocityCutoff, dt);
+    float alphaA = Impl::smoothingAlpha(pImpl->config.accelerationCutoff, dt);
+
+    // 軸角度が大きく跳んだ関節は速度を持ち越さない
+    std::array<bool, 24> discontinuous{};
+    for (int j = 0; j < 24; ++j) {
+      for (int k = 0; k < 3; ++k) {
+        int c = POSE_OFFSET + j * 3 + k;
+        if (std::abs(current[c] - pImpl->value[c]) > AXIS_ANGLE_DISCONTINUITY) discontinuous[j] = true;
+      }
+    }
+
+    for (int c = 0; c < NUM_CHANNELS; ++c) {
+      if (c >= POSE_OFFSET && c < TRANSLATION_OFFSET && discontinuous[(c - POSE_OFFSET) / 3]) {
+        pImpl->velocity[c] = 0.0f;
+        pImpl->acceleration[c] = 0.0f;
+        continue;
+      }
+      // 最初の差分はそのまま速度とし、加速度は2回目の速度推定から
+      float rawVelocity = (current[c] - pImpl->value[c]) / dt;
+      float v = pImpl->numMeasurements == 1
+                    ? rawVelocity
+                    : pImpl->velocity[c] + alphaV * (rawVelocity - pImpl->velocity[c]);
+      if (pImpl->numMeasurements > 1) {
+        float a = (v - pImpl->velocity[c]) / dt;
+        pImpl->acceleration[c] += alphaA * (a - pImpl->acceleration[c]);
+      }
+      pImpl->velocity[c] = v;
+    }
+  } else if (pImpl->numMeasurements > 0 && dt <= 0.0f) {
+    // 時刻が進まない・巻き戻った場合は推定をやり直す
+    pImpl->velocity.fill(0.0f);
+    pImpl->acceleration.fill(0.0f);
+    pImpl->numMeasurements = 0;
+  }
+
+  pImpl->value = current;
+  pImpl->lastPose = pose;
+  pImpl->lastParams = params;
+  pImpl->lastTimestamp = timestamp;
+  ++pImpl->numMeasurements;
+}
+
+void PosePredictor::predict(float timestamp, BodyPose &pose, SMPLParams &params) const {
+  pose = pImpl->lastPose;
+  params = pImpl->lastParams;
+  if (pImpl->numMeasurements < 2) return;
+
+  float maxHorizon = pImpl->config.maxHorizonMs * 0.001f;
+  float h = std::clamp(timestamp - pImpl->lastTimestamp, 0.0f, maxHorizon);
+  if (h <= 0.0f) return;
+  float halfH2 = 0.5f * h * h;
+
+  auto offset = [&](int c) { return pImpl->velocity[c] * h + pImpl->acceleration[c] * halfH2; };
+
+  // 見えにくいランドマークほど外挿を弱める
+  float minVisibility = pImpl->config.minVisibility;
+  for (int i = 0; i < NUM_LANDMARKS; ++i) {
+    float gain = std::clamp((pose.visibility[i] - minVisibility) / std::max(1.0f - minVisibility, 1e-3f),
+                            0.0f, 1.0f);
+    pose.landmarks[i].x += gain * offset(i * 3);
+    pose.landmarks[i].y += gain * offset(i * 3 + 1);
+    pose.landmarks[i].z += gain * offset(i * 3 + 2);
+  }
+  for (int k = 0; k < 72; ++k) params.pose[k] += offset(POSE_OFFSET + k);
+  for (int k = 0; k < 3; ++k) params.translation[k] += offset(TRANSLATION_OFFSET + k);
+  params.scale = std::max(params.scale + offset(SCALE_OFFSET), 1e-3f);
+
+  // 予測が先になるほど信頼度を下げる（予測上限で半減）
+  float falloff = 1.0f - 0.5f * h / std::max(maxHorizon, 1e-3f);
+  pose.confidence = std::clamp(pose.confidence * falloff, 0.0f, 1.0f);
+}
+
+bool PosePredictor::hasMeasurement() const { return pImpl->numMeasurements > 0; }
+
+void PosePredictor::reset() {
+  pImpl->numMeasurements = 0;
+  pImpl->velocity.fill(0.0f);
+  pImpl->acceleration.fill(0.0f);
+}
+
+} // namespace arfit
@@ -0,0 +1,130 @@
+/**
+ * @file segmentation_mask.cpp
+ * @brief セグメンテーションマスクの符号化とエッジ保存アップサンプリング
+ */
+
+#include "segmentation_mask.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+
+namespace arfit {
+
+void SegmentationMask::allocate(int w, int h, MaskFormat fmt, int srcW, int srcH) {
+  format = fmt;
+  width = w;
+  height = h;
+  sourceWidth = srcW;
+  sourceHeight = srcH;
+  rowStride = fmt == MaskFormat::UINT8 ? w : (w + 7) / 8;
+  data.assign((size_t)rowStride * h, 0);
+}
+
+void encodeRunLength(const SegmentationMask &mask, RunLengthMask &rle) {
+  rle.width = mask.width;
+  rle.height = mask.height;
+  rle.runs.clear();
+  rle.rowStart.resize(mask.height + 1);
+
+  for (int y = 0; y < mask.height; ++y) {
+    rle.rowStart[y] = (uint32_t)rle.runs.size();
+    bool foreground = false;
+    int runStart = 0;
+    for (int x = 0; x <= mask.width; ++x) {
+      bool value = x < mask.width && mask.at(x, y) >= 128;
+      if (x < mask.width && value == foreground) continue;
+      rle.runs.push_back((uint16_t)(x - runStart));
+      foreground = !foreground;
+      runStart = x;
+      if (x == mask.width) break;
+    }
+  }
+  rle.rowStart[mask.height] = (uint32_t)rle.runs.size();
+}
+
+void decodeRunLength(const RunLengthMask &rle, MaskFormat format, int sourceWidth,
+                     int sourceHeight, SegmentationMask &mask) {
+  mask.allocate(rle.width, rle.height, format, sourceWidth, sourceHeight);
+  for (int y = 0; y < rle.height; ++y) {
+    int x = 0;
+    bool foreground = false;
+    for (uint32_t r = rle.rowStart[y]; r < rle.rowStart[y + 1]; ++r) {
+      int end = std::min<int>(x + rle.runs[r], rle.width);
+      if (foreground) {
+        for (int i = x; i < end; ++i) mask.set(i, y, 255);
+      }
+      x = end;
+      foreground = !foreground;
+    }
+  }
+}
+
+void upsampleMask(const SegmentationMask &mask, const ImageData &guide, std::vector<uint8_t> &out) {
+  const int W = guide.width, H = guide.height, channels = guide.channels;
+  out.assign((size_t)W * H, 0);
+  if (mask.empty() || W <= 0 || H <= 0) return;
+
+  const int w = mask.width, h = mask.height;
+  const float sx = (float)w / W, sy = (float)h / H;
+
+  // 各マスク画素の中心に対応するフレームの色（範囲重みの基準）
+  std::vector<uint8_t> centerColor((size_t)w * h * 3);
+  for (int my = 0; my < h; ++my) {
+    int gy = std::min(H - 1, (int)((my + 0.5f) / sy));
+    for (int mx = 0; mx < w; ++mx) {
+      int gx = std::min(W - 1, (int)((mx + 0.5f) / sx));
+      const uint8_t *p = &guide.pixels[((size_t)gy * W + gx) * channels];
+      for (int c = 0; c < 3; ++c) centerColor[((size_t)my * w + mx) * 3 + c] = p[std::min(c, channels - 1)];
+    }
+  }
+
+  // 色差 (|ΔR|+|ΔG|+|ΔB|) に対するガウス重みの表
+  constexpr float RANGE_SIGMA = 40.0f;
+  std::array<float, 766> rangeWeight;
+  for (int d = 0; d < 766; ++d) {
+    float t = d / RANGE_SIGMA;
+    rangeWeight[d] = std::exp(-0.5f * t * t);
+  }
+
+  ThreadPool::shared().parallelFor(0, H, 32, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; ++y) {
+      float my = (y + 0.5f) * sy - 0.5f;
+      int y0 = std::clamp((int)std::floor(my), 0, h - 1), y1 = std::min(y0 + 1, h - 1);
+      float fy = std::clamp(my - y0, 0.0f, 1.0f);
+      uint8_t *dst = &out[y * W];
+      const uint8_t *pixelRow = &guide.pixels[y * W * channels];
+
+      for (int x = 0; x < W; ++x) {
+        float mx = (x + 0.5f) * sx - 0.5f;
+        int x0 = std::clamp((int)std::floor(mx), 0, w - 1), x1 = std::min(x0 + 1, w - 1);
+        uint8_t v00 = mask.at(x0, y0), v01 = mask.at(x1, y0);
+        uint8_t v10 = mask.at(x0, y1), v11 = mask.at(x1, y1);
+
+        // 近傍が一致する内部・外部は色を見ずに埋める
+        if (v00 == v01 && v00 == v10 && v00 == v11) {
+          dst[x] = v00;
+          continue;
+        }
+
+        float fx = std::clamp(mx - x0, 0.0f, 1.0f);
+        const uint8_t *p = pixelRow + (size_t)x * channels;
+        int r = p[0], g = p[std::min(1, channels - 1)], b = p[std::min(2, channels - 1)];
+        auto weight = [&](int qx, int qy, float spatial) {
+          const uint8_t *c = &centerColor[((size_t)qy * w + qx) * 3];
+          return spatial * rangeWeight[std::abs(r - c[0]) + std::abs(g - c[1]) + std::abs(b - c[2])];
+        };
+        float w00 = weight(x0, y0, (1 - fx) * (1 - fy)), w01 = weight(x1, y0, fx * (1 - fy));
+        float w10 = weight(x0, y1, (1 - fx) * fy), w11 = weight(x1, y1, fx * fy);
+        float total = w00 + w01 + w10 + w11;
+        float value = total > 1e-6f
+                          ? (w00 * v00 + w01 * v01 + w10 * v10 + w11 * v11) / total
+                          : (1 - fy) * ((1 - fx) * v00 + fx * v01) + fy * ((1 - fx) * v10 + fx * v11);
+        dst[x] = (uint8_t)std::lround(value);
+      }
+    }
+  });
+}
+
+} // namespace arfit
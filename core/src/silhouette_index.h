@@ -0,0 +1,323 @@
+/**
+ * @file silhouette_index.h
+ * @brief Per-row foreground span index of a garment mask (internal)
+ */
+
+#pragma once
+
+#include "simd.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace arfit {
+
+/**
+ * @brief Horizontal run of foreground pixels, inclusive on both ends
+ */
+struct SilhouetteSpan {
+  int left = -1;
+  int right = -1;
+
+  bool empty() const { return left < 0; }
+  int width() const { return right - left + 1; }
+};
+
+/**
+ * @brief Bounding rectangle of the foreground
+ */
+struct SilhouetteBounds {
+  int x = 0;
+  int y = 0;
+  int width = 0;
+  int height = 0;
+};
+
+/**
+ * @brief Row-span index of a binary silhouette
+ *
+ * build() makes a single pass over the mask, 16 pixels at a time, and
+ * records every foreground run of every row. After that the outer extent of
+ * a row is an O(1) lookup, and multi-segment rows (sleeves apart from the
+ * torso, trouser legs) expose their individual runs. Buffers are kept
+ * between builds.
+ */
+class SilhouetteIndex {
+public:
+  /**
+   * @brief Index a single-channel 8-bit mask
+   * @param stride Bytes between rows
+   * @param threshold Pixels strictly above this are foreground
+   */
+  void build(const uint8_t *data, int width, int height, size_t stride, uint8_t threshold) {
+    cols = std::max(width, 0);
+    extents.assign(std::max(height, 0), SilhouetteSpan{});
+    offsets.assign(extents.size() + 1, 0);
+    if (cols == 0 || extents.empty()) {
+      spanData.clear();
+      return;
+    }
+
+    // 行ブロックごとに並列に走査し、ブロック内の区間を後で連結する
+    const size_t numBlocks = (extents.size() + ROWS_PER_BLOCK - 1) / ROWS_PER_BLOCK;
+    blocks.resize(numBlocks);
+    ThreadPool::shared().parallelFor(0, numBlocks, 1, [&](size_t begin, size_t end) {
+      for (size_t b = begin; b < end; ++b) {
+        std::vector<SilhouetteSpan> &out = blocks[b];
+        out.clear();
+        size_t y0 = b * ROWS_PER_BLOCK, y1 = std::min(y0 + ROWS_PER_BLOCK, extents.size());
+        for (size_t y = y0; y < y1; ++y) {
+          size_t first = out.size();
+          scanRow(data + y * stride, threshold, out);
+          offsets[y + 1] = (uint32_t)(out.size() - first);
+          if (out.size() > first) extents[y] = {out[first].left, out.back().right};
+        }
+      }
+    });
+
+    // 行ごとの区間数を累積オフセットに変換
+    for (size_t y = 0; y < extents.size(); ++y) offsets[y + 1] += offsets[y];
+    spanData.resize(offsets.back());
+    for (size_t b = 0; b < numBlocks; ++b) {
+      std::copy(blocks[b].begin(), blocks[b].end(), spanData.begin() + offsets[b * ROWS_PER_BLOCK]);
+    }
+  }
+
+  int width() const { return cols; }
+  int height() const { return (int)extents.size(); }
+
+  /**
+   * @brief Leftmost to rightmost foreground pixel of a row (empty if none)
+   */
+  const SilhouetteSpan &extent(int y) const { return extents[y]; }
+
+  /**
+   * @brief Number of separate foreground runs in a row
+   */
+  int spanCount(int y) const { return (int)(offsets[y + 1] - offsets[y]); }
+
+  /**
+   * @brief Foreground runs of a row, left to right
+   */
+  const SilhouetteSpan *spans(int y) const { return spanData.data() + offsets[y]; }
+
+  /**
+   * @brief Bounding rectangle of all indexed spans (empty if none)
+   */
+  SilhouetteBounds bounds() const {
+    SilhouetteBounds b;
+    int top = -1, bottom = -1, left = cols, right = -1;
+    for (int y = 0; y < height(); ++y) {
+      if (extents[y].empty()) continue;
+      if (top < 0) top = y;
+      bottom = y;
+      left = std::min(left, extents[y].left);
+      right = std::max(right, extents[y].right);
+    }
+    if (top >= 0) b = {left, top, right - left + 1, bottom - top + 1};
+    return b;
+  }
+
+  /**
+   * @brief Keep only the largest 8-connected foreground component
+   *
+   * Union-find runs over the indexed spans rather than pixels, so the cost
+   * is proportional to the number of runs. Spans of all other components
+   * are dropped from the index and cleared to zero in the mask it was
+   * built from.
+   *
+   * @param data Mask passed to build()
+   * @param stride Bytes between rows
+   */
+  void retainLargestComponent(uint8_t *data, size_t stride) {
+    const uint32_t numSpans = (uint32_t)spanData.size();
+    if (numSpans <= 1) return;
+
+    parents.resize(numSpans);
+    for (uint32_t i = 0; i < numSpans; ++i) parents[i] = i;
+
+    // 上下の行で横方向に重なる（斜めに接する）区間同士を結合
+    for (int y = 1; y < height(); ++y) {
+      uint32_t i = offsets[y - 1], iEnd = offsets[y];
+      uint32_t j = offsets[y], jEnd = offsets[y + 1];
+      while (i < iEnd && j < jEnd) {
+        const SilhouetteSpan &above = spanData[i], &below = spanData[j];
+        if (above.left <= below.right + 1 && below.left <= above.right + 1) unite(i, j);
+        if (above.right < below.right) {
+          ++i;
+        } else if (below.right < above.right) {
+          ++j;
+        } else {
+          ++i;
+          ++j;
+        }
+      }
+    }
+
+    // 成分ごとの画素数を集計し、最大のものを選ぶ
+    areas.assign(numSpans, 0);
+    uint32_t largest = 0;
+    for (uint32_t i = 0; i < numSpans; ++i) {
+      uint32_t root = find(i);
+      areas[root] += (uint64_t)spanData[i].width();
+      if (areas[root] > areas[largest]) largest = root;
+    }
+
+    // 残す区間だけを詰め直し、捨てた区間はマスクから消す
+    uint32_t write = 0, rowStart = 0;
+    for (int y = 0; y < height(); ++y) {
+      for (uint32_t i = rowStart; i < offsets[y + 1]; ++i) {
+        const SilhouetteSpan span = spanData[i];
+        if (find(i) == largest) {
+          spanData[write++] = span;
+        } else {
+          std::fill(data + y * stride + span.left, data + y * stride + span.right + 1, (uint8_t)0);
+        }
+      }
+      rowStart = offsets[y + 1];
+      offsets[y + 1] = write;
+      uint32_t first = offsets[y];
+      extents[y] = write > first ? SilhouetteSpan{spanData[first].left, spanData[write - 1].right} : SilhouetteSpan{};
+    }
+    spanData.resize(write);
+  }
+
+private:
+  static constexpr size_t ROWS_PER_BLOCK = 64;
+
+  int cols = 0;
+  std::vector<SilhouetteSpan> extents;
+  std::vector<uint32_t> offsets; // 行yの区間は spanData[offsets[y], offsets[y + 1])
+  std::vector<SilhouetteSpan> spanData;
+  std::vector<std::vector<SilhouetteSpan>> blocks;
+  std::vector<uint32_t> parents; // 連結成分の Union-Find
+  std::vector<uint64_t> areas;
+
+  uint32_t find(uint32_t i) {
+    while (parents[i] != i) {
+      parents[i] = parents[parents[i]];
+      i = parents[i];
+    }
+    return i;
+  }
+
+  void unite(uint32_t a, uint32_t b) {
+    a = find(a);
+    b = find(b);
+    if (a != b) parents[std::max(a, b)] = std::min(a, b);
+  }
+
+  static int lowestBit(uint32_t bits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (int)index;
+#else
+    return __builtin_ctz(bits);
+#endif
+  }
+
+  // 16画素を比較し、前景の画素をビットにしたマスクを返す
+  static uint32_t foreground16(const uint8_t *p, uint8_t threshold) {
+#if defined(ARFIT_SIMD_SSE2)
+    // SSE2には符号なし比較がないため、符号ビットを反転して符号付きで比較
+    const __m128i bias = _mm_set1_epi8((char)0x80);
+    __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), bias);
+    __m128i t = _mm_xor_si128(_mm_set1_epi8((char)threshold), bias);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(v, t));
+#elif defined(ARFIT_SIMD_NEON)
+    static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t above = vcgtq_u8(vld1q_u8(p), vdupq_n_u8(threshold));
+    uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vandq_u8(above, vld1q_u8(weights)))));
+    return (uint32_t)(vgetq_lane_u64(sums, 0) | (vgetq_lane_u64(sums, 1) << 8));
+#else
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; ++i) bits |= (uint32_t)(p[i] > threshold) << i;
+    return bits;
+#endif
+  }
+
+  void scanRow(const uint8_t *row, uint8_t threshold, std::vector<SilhouetteSpan> &out) const {
+    bool inside = false;
+    int start = 0;
+
+    // ビット列の 0→1 / 1→0 の切り替わりだけを拾う（一様なブロックは即座に飛ばす）
+    auto consume = [&](int x, uint32_t bits, int n) {
+      const uint32_t valid = (1u << n) - 1;
+      int pos = 0;
+      while (pos < n) {
+        uint32_t rest = (inside ? ~bits : bits) & valid & (~0u << pos);
+        if (!rest) break;
+        int bit = lowestBit(rest);
+        if (inside) {
+          out.push_back({start, x + bit - 1});
+        } else {
+          start = x + bit;
+        }
+        inside = !inside;
+        pos = bit + 1;
+      }
+    };
+
+    int x = 0;
+    for (; x + 16 <= cols; x += 16) consume(x, foreground16(row + x, threshold), 16);
+    if (x < cols) {
+      uint32_t bits = 0;
+      for (int i = 0; x + i < cols; ++i) bits |= (uint32_t)(row[x + i] > threshold) << i;
+      consume(x, bits, cols - x);
+    }
+    if (inside) out.push_back({start, cols - 1});
+  }
+};
+
+/**
+ * @brief Threshold the alpha channel of an RGBA image into a binary mask
+ *
+ * Reads alpha directly from the interleaved pixels, 16 at a time, and
+ * writes 255 where alpha is above the threshold and 0 elsewhere. Rows are
+ * processed in parallel.
+ *
+ * @param rgba Source pixels, 4 bytes each
+ * @param srcStride Bytes between source rows
+ * @param mask Destination, 1 byte per pixel
+ * @param maskStride Bytes between mask rows
+ */
+inline void thresholdAlpha(const uint8_t *rgba, size_t srcStride, int width, int height, uint8_t *mask,
+                           size_t maskStride, uint8_t threshold) {
+  ThreadPool::shared().parallelFor(0, (size_t)std::max(height, 0), 16, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; ++y) {
+      const uint8_t *src = rgba + y * srcStride;
+      uint8_t *dst = mask + y * maskStride;
+      int x = 0;
+#if defined(ARFIT_SIMD_SSE2)
+      // 各画素の上位バイト（アルファ）を取り出して16画素分に詰め、符号を反転して比較
+      const __m128i bias = _mm_set1_epi8((char)0x80);
+      const __m128i limit = _mm_xor_si128(_mm_set1_epi8((char)threshold), bias);
+      for (; x + 16 <= width; x += 16) {
+        const __m128i *p = reinterpret_cast<const __m128i *>(src + x * 4);
+        __m128i a0 = _mm_srli_epi32(_mm_loadu_si128(p), 24);
+        __m128i a1 = _mm_srli_epi32(_mm_loadu_si128(p + 1), 24);
+        __m128i a2 = _mm_srli_epi32(_mm_loadu_si128(p + 2), 24);
+        __m128i a3 = _mm_srli_epi32(_mm_loadu_si128(p + 3), 24);
+        __m128i alpha = _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+        __m128i above = _mm_cmpgt_epi8(_mm_xor_si128(alpha, bias), limit);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), above);
+      }
+#elif defined(ARFIT_SIMD_NEON)
+      const uint8x16_t limit = vdupq_n_u8(threshold);
+      for (; x + 16 <= width; x += 16) {
+        uint8x16x4_t px = vld4q_u8(src + x * 4);
+        vst1q_u8(dst + x, vcgtq_u8(px.val[3], limit));
+      }
+#endif
+      for (; x < width; ++x) dst[x] = src[x * 4 + 3] > threshold ? 255 : 0;
+    }
+  });
+}
+
+} // namespace arfit
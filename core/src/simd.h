@@ -0,0 +1,151 @@
+/**
+ * @file simd.h
+ * @brief Minimal 4-wide float SIMD wrapper over SSE2 / NEON with a scalar fallback (internal)
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ARFIT_SIMD_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ARFIT_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace arfit {
+namespace simd {
+
+#if defined(ARFIT_SIMD_SSE2)
+
+struct Float4 {
+  __m128 v;
+};
+
+inline Float4 load(const float *p) { return {_mm_loadu_ps(p)}; }
+inline void store(float *p, Float4 a) { _mm_storeu_ps(p, a.v); }
+inline Float4 splat(float s) { return {_mm_set1_ps(s)}; }
+inline Float4 zero() { return {_mm_setzero_ps()}; }
+inline Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Float4 madd(Float4 a, Float4 b, Float4 c) { return {_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)}; }
+inline Float4 min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline Float4 max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+inline Float4 operator/(Float4 a, Float4 b) { return {_mm_div_ps(a.v, b.v)}; }
+inline Float4 abs(Float4 a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+
+/** Load 4 bytes (e.g. one RGBA pixel) as floats */
+inline Float4 loadBytes(const uint8_t *p) {
+  int32_t bits;
+  std::memcpy(&bits, p, 4);
+  __m128i v = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), _mm_setzero_si128());
+  return {_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, _mm_setzero_si128()))};
+}
+/** Round and saturate to 4 bytes */
+inline void storeBytes(uint8_t *p, Float4 a) {
+  __m128i v = _mm_cvtps_epi32(a.v);
+  v = _mm_packs_epi32(v, v);
+  int32_t bits = _mm_cvtsi128_si32(_mm_packus_epi16(v, v));
+  std::memcpy(p, &bits, 4);
+}
+
+#elif defined(ARFIT_SIMD_NEON)
+
+struct Float4 {
+  float32x4_t v;
+};
+
+inline Float4 load(const float *p) { return {vld1q_f32(p)}; }
+inline void store(float *p, Float4 a) { vst1q_f32(p, a.v); }
+inline Float4 splat(float s) { return {vdupq_n_f32(s)}; }
+inline Float4 zero() { return {vdupq_n_f32(0.0f)}; }
+inline Float4 operator+(Float4 a, Float4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline Float4 operator-(Float4 a, Float4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline Float4 operator*(Float4 a, Float4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline Float4 madd(Float4 a, Float4 b, Float4 c) { return {vmlaq_f32(c.v, a.v, b.v)}; }
+inline Float4 min(Float4 a, Float4 b) { return {vminq_f32(a.v, b.v)}; }
+inline Float4 max(Float4 a, Float4 b) { return {vmaxq_f32(a.v, b.v)}; }
+inline Float4 operator/(Float4 a, Float4 b) {
+#if defined(__aarch64__)
+  return {vdivq_f32(a.v, b.v)};
+#else
+  // ARMv7 has no vector divide: reciprocal estimate + two Newton-Raphson steps
+  float32x4_t r = vrecpeq_f32(b.v);
+  r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+  r = vmulq_f32(vrecpsq_f32(b.v, r), r);
+  return {vmulq_f32(a.v, r)};
+#endif
+}
+inline Float4 abs(Float4 a) { return {vabsq_f32(a.v)}; }
+
+/** Load 4 bytes (e.g. one RGBA pixel) as floats */
+inline Float4 loadBytes(const uint8_t *p) {
+  uint32_t bits;
+  std::memcpy(&bits, p, 4);
+  uint16x8_t wide = vmovl_u8(vcreate_u8(bits));
+  return {vcvtq_f32_u32(vmovl_u16(vget_low_u16(wide)))};
+}
+/** Round and saturate to 4 bytes */
+inline void storeBytes(uint8_t *p, Float4 a) {
+  float32x4_t rounded = vaddq_f32(vmaxq_f32(a.v, vdupq_n_f32(0.0f)), vdupq_n_f32(0.5f));
+  uint16x4_t narrow = vqmovn_u32(vcvtq_u32_f32(rounded));
+  uint8x8_t bytes = vqmovn_u16(vcombine_u16(narrow, narrow));
+  uint32_t bits = vget_lane_u32(vreinterpret_u32_u8(bytes), 0);
+  std::memcpy(p, &bits, 4);
+}
+
+#else
+
+struct Float4 {
+  float v[4];
+};
+
+inline Float4 load(const float *p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store(float *p, Float4 a) {
+  for (int i = 0; i < 4; ++i) p[i] = a.v[i];
+}
+inline Float4 splat(float s) { return {{s, s, s, s}}; }
+inline Float4 zero() { return splat(0.0f); }
+#define ARFIT_SIMD_LANEWISE(expr)                                              \
+  Float4 r;                                                                    \
+  for (int i = 0; i < 4; ++i) r.v[i] = (expr);                                 \
+  return r;
+inline Float4 operator+(Float4 a, Float4 b) { ARFIT_SIMD_LANEWISE(a.v[i] + b.v[i]) }
+inline Float4 operator-(Float4 a, Float4 b) { ARFIT_SIMD_LANEWISE(a.v[i] - b.v[i]) }
+inline Float4 operator*(Float4 a, Float4 b) { ARFIT_SIMD_LANEWISE(a.v[i] * b.v[i]) }
+inline Float4 madd(Float4 a, Float4 b, Float4 c) { ARFIT_SIMD_LANEWISE(a.v[i] * b.v[i] + c.v[i]) }
+inline Float4 min(Float4 a, Float4 b) { ARFIT_SIMD_LANEWISE(a.v[i] < b.v[i] ? a.v[i] : b.v[i]) }
+inline Float4 max(Float4 a, Float4 b) { ARFIT_SIMD_LANEWISE(a.v[i] > b.v[i] ? a.v[i] : b.v[i]) }
+inline Float4 operator/(Float4 a, Float4 b) { ARFIT_SIMD_LANEWISE(a.v[i] / b.v[i]) }
+inline Float4 abs(Float4 a) { ARFIT_SIMD_LANEWISE(a.v[i] < 0.0f ? -a.v[i] : a.v[i]) }
+#undef ARFIT_SIMD_LANEWISE
+
+/** Load 4 bytes (e.g. one RGBA pixel) as floats */
+inline Float4 loadBytes(const uint8_t *p) { return {{(float)p[0], (float)p[1], (float)p[2], (float)p[3]}}; }
+/** Round and saturate to 4 bytes */
+inline void storeBytes(uint8_t *p, Float4 a) {
+  for (int i = 0; i < 4; ++i) {
+    float v = a.v[i] < 0.0f ? 0.0f : (a.v[i] > 255.0f ? 255.0f : a.v[i]);
+    p[i] = (uint8_t)(v + 0.5f);
+  }
+}
+
+#endif
+
+/**
+ * @brief y[i] += a * x[i] for i in [0, n); n must be a multiple of 4
+ */
+inline void axpy(float a, const float *x, float *y, size_t n) {
+  Float4 va = splat(a);
+  for (size_t i = 0; i < n; i += 4) {
+    store(y + i, madd(va, load(x + i), load(y + i)));
+  }
+}
+
+} // namespace simd
+} // namespace arfit
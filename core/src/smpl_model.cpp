@@ -0,0 +1,225 @@
+/**
+ * @file smpl_model.cpp
+ * @brief SMPLモデルのバイナリ形式の読み込み（メモリマップ）
+ *
+ * ファイルはそのままマップし、ヘッダー・セクション表と、後段が添字として
+ * そのまま使う小さな索引（親関節・関節回帰子の疎行列）の検証以外は一切
+ * パースしません。大きな配列のページは実際に参照されたときに読み込まれます。
+ */
+
+#include "smpl_model.h"
+#include "body_tracker.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace arfit {
+
+class SMPLModel::Impl {
+public:
+  SMPLModelData data;
+
+  // メモリマップ（またはフォールバック時の読み込みバッファ）
+  const uint8_t *mapping = nullptr;
+  size_t mappingSize = 0;
+  bool mapped = false;
+
+  // プレースホルダー・フォールバック用の所有ストレージ
+  std::vector<uint8_t> fileBuffer;
+  std::vector<float> templateVertices;
+  std::vector<float> shapeDirs;
+  std::vector<float> poseDirs;
+  std::vector<float> skinWeights;
+  std::vector<int32_t> parents;
+  std::vector<int32_t> regressorRowStart;
+  std::vector<uint32_t> groupJointMask;
+
+  ~Impl() {
+#if !defined(_WIN32)
+    if (mapped) munmap(const_cast<uint8_t *>(mapping), mappingSize);
+#endif
+  }
+
+  /**
+   * ファイル全体をマップ（Windowsでは読み込みで代替）
+   */
+  bool mapFile(const std::string &path) {
+#if defined(_WIN32)
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    fileBuffer.resize(static_cast<size_t>(in.tellg()));
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char *>(fileBuffer.data()), fileBuffer.size())) return false;
+    mapping = fileBuffer.data();
+    mappingSize = fileBuffer.size();
+    return true;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+      close(fd);
+      return false;
+    }
+    void *addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return false;
+    mapping = static_cast<const uint8_t *>(addr);
+    mappingSize = static_cast<size_t>(st.st_size);
+    mapped = true;
+    return true;
+#endif
+  }
+
+  /**
+   * セクションの範囲・アラインメント・サイズを検証してポインタを返す
+   */
+  template <typename T>
+  const T *section(const SMPLModelSection *sections, uint32_t id, size_t count) const {
+    const SMPLModelSection &s = sections[id];
+    if (s.offset % SMPL_MODEL_ALIGNMENT != 0 || s.size != count * sizeof(T) ||
+        s.offset > mappingSize || s.size > mappingSize - s.offset) {
+      return nullptr;
+    }
+    return reinterpret_cast<const T *>(mapping + s.offset);
+  }
+
+  std::string validate() {
+    if (mappingSize < sizeof(SMPLModelHeader)) return "File too small";
+    SMPLModelHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+
+    if (std::memcmp(header.magic, SMPL_MODEL_MAGIC, sizeof(header.magic)) != 0) {
+      return "Not an ARFit SMPL model file";
+    }
+    if (header.version != SMPL_MODEL_VERSION) {
+      return "Unsupported SMPL model version " + std::to_string(header.version);
+    }
+    if (header.numVertices != (uint32_t)SMPL_NUM_VERTICES ||
+        header.paddedVertices != (uint32_t)((SMPL_NUM_VERTICES + 3) & ~3) ||
+        header.numJoints != (uint32_t)SMPL_NUM_JOINTS ||
+        header.numBetas != (uint32_t)SMPL_NUM_BETAS ||
+        header.numPoseFeatures != (uint32_t)SMPL_NUM_POSE_FEATURES) {
+      return "SMPL model dimensions do not match";
+    }
+    if (header.sectionCount < SMPL_SECTION_COUNT ||
+        sizeof(header) + header.sectionCount * sizeof(SMPLModelSection) > mappingSize) {
+      return "Truncated section table";
+    }
+
+    auto *sections = reinterpret_cast<const SMPLModelSection *>(mapping + sizeof(header));
+    size_t vp = header.paddedVertices;
+    data.numVertices = header.numVertices;
+    data.paddedVertices = header.paddedVertices;
+    data.numJoints = header.numJoints;
+    data.numBetas = header.numBetas;
+    data.numPoseFeatures = header.numPoseFeatures;
+    data.templateVertices = section<float>(sections, SMPL_SECTION_TEMPLATE, 3 * vp);
+    data.shapeDirs = section<float>(sections, SMPL_SECTION_SHAPE_DIRS, header.numBetas * 3 * vp);
+    data.poseDirs = section<float>(sections, SMPL_SECTION_POSE_DIRS, header.numPoseFeatures * 3 * vp);
+    data.skinWeights = section<float>(sections, SMPL_SECTION_SKIN_WEIGHTS, header.numJoints * vp);
+    data.parents = section<int32_t>(sections, SMPL_SECTION_PARENTS, header.numJoints);
+    data.regressorRowStart = section<int32_t>(sections, SMPL_SECTION_REGRESSOR_ROWS, header.numJoints + 1);
+    data.regressorVertex = section<int32_t>(sections, SMPL_SECTION_REGRESSOR_VERTEX, header.regressorNonZeros);
+    data.regressorWeight = section<float>(sections, SMPL_SECTION_REGRESSOR_WEIGHT, header.regressorNonZeros);
+    data.groupJointMask = section<uint32_t>(sections, SMPL_SECTION_GROUP_JOINT_MASK, vp / 4);
+
+    if (!data.templateVertices || !data.shapeDirs || !data.poseDirs || !data.skinWeights ||
+        !data.parents || !data.regressorRowStart || !data.groupJointMask ||
+        (header.regressorNonZeros > 0 && (!data.regressorVertex || !data.regressorWeight))) {
+      return "Corrupt section table";
+    }
+    return validateIndices(header.regressorNonZeros);
+  }
+
+  /**
+   * 運動連鎖と関節回帰で検査なしに使われる添字を確かめる
+   */
+  std::string validateIndices(uint32_t regressorNonZeros) const {
+    // 親関節はルートのみ-1、それ以外は自分より前の関節（前から順に累積できること）
+    for (int j = 0; j < data.numJoints; ++j) {
+      int32_t parent = data.parents[j];
+      if (j == 0 ? parent != -1 : (parent < 0 || parent >= j)) {
+        return "Invalid parent of joint " + std::to_string(j);
+      }
+    }
+
+    // 回帰子の行は0から始まり、単調非減少で非ゼロ要素数を超えない
+    if (data.regressorRowStart[0] != 0) return "Invalid joint regressor rows";
+    for (int j = 0; j < data.numJoints; ++j) {
+      if (data.regressorRowStart[j + 1] < data.regressorRowStart[j] ||
+          (uint32_t)data.regressorRowStart[j + 1] > regressorNonZeros) {
+        return "Invalid joint regressor rows";
+      }
+    }
+    for (uint32_t i = 0; i < regressorNonZeros; ++i) {
+      if (data.regressorVertex[i] < 0 || data.regressorVertex[i] >= data.numVertices) {
+        return "Joint regressor vertex out of range";
+      }
+    }
+    return "";
+  }
+};
+
+SMPLModel::SMPLModel() : pImpl(std::make_unique<Impl>()) {}
+SMPLModel::~SMPLModel() = default;
+
+Result<std::shared_ptr<SMPLModel>> SMPLModel::load(const std::string &path) {
+  auto model = std::make_shared<SMPLModel>();
+  if (!model->pImpl->mapFile(path)) {
+    return {.error = ErrorCode::MODEL_LOAD_FAILED,
+            .message = "Cannot map SMPL model: " + path};
+  }
+
+  std::string error = model->pImpl->validate();
+  if (!error.empty()) {
+    return {.error = ErrorCode::MODEL_LOAD_FAILED, .message = error + ": " + path};
+  }
+  return {.value = model, .error = ErrorCode::SUCCESS};
+}
+
+std::shared_ptr<SMPLModel> SMPLModel::createPlaceholder() {
+  auto model = std::make_shared<SMPLModel>();
+  Impl &m = *model->pImpl;
+
+  // SMPLの基本テンプレート (6890頂点) をゼロで初期化し、全頂点をルートに剛体追従させる
+  const size_t vp = (SMPL_NUM_VERTICES + 3) & ~3;
+  m.templateVertices.assign(3 * vp, 0.0f);
+  m.shapeDirs.assign(SMPL_NUM_BETAS * 3 * vp, 0.0f);
+  m.poseDirs.assign(SMPL_NUM_POSE_FEATURES * 3 * vp, 0.0f);
+  m.skinWeights.assign(SMPL_NUM_JOINTS * vp, 0.0f);
+  std::fill(m.skinWeights.begin(), m.skinWeights.begin() + SMPL_NUM_VERTICES, 1.0f);
+  m.parents = {-1, 0, 0, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 9, 9, 12, 13, 14, 16, 17, 18, 19, 20, 21};
+  m.regressorRowStart.assign(SMPL_NUM_JOINTS + 1, 0);
+  m.groupJointMask.assign(vp / 4, 0);
+  for (int v = 0; v < SMPL_NUM_VERTICES; ++v) m.groupJointMask[v / 4] = 1u;
+
+  m.data.numVertices = SMPL_NUM_VERTICES;
+  m.data.paddedVertices = (int)vp;
+  m.data.numJoints = SMPL_NUM_JOINTS;
+  m.data.numBetas = SMPL_NUM_BETAS;
+  m.data.numPoseFeatures = SMPL_NUM_POSE_FEATURES;
+  m.data.templateVertices = m.templateVertices.data();
+  m.data.shapeDirs = m.shapeDirs.data();
+  m.data.poseDirs = m.poseDirs.data();
+  m.data.skinWeights = m.skinWeights.data();
+  m.data.parents = m.parents.data();
+  m.data.regressorRowStart = m.regressorRowStart.data();
+  m.data.groupJointMask = m.groupJointMask.data();
+  return model;
+}
+
+const SMPLModelData &SMPLModel::data() const { return pImpl->data; }
+
+bool SMPLModel::isMemoryMapped() const { return pImpl->mapped; }
+
+} // namespace arfit
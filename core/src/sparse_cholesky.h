@@ -0,0 +1,176 @@
+/**
+ * @file sparse_cholesky.h
+ * @brief Envelope (skyline) sparse Cholesky factorization with RCM ordering (internal)
+ */
+
+#pragma once
+
+#include "types.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <vector>
+
+namespace arfit {
+
+/**
+ * @brief Factorizes a sparse SPD matrix once and solves A x = b repeatedly
+ *
+ * Rows are reordered with reverse Cuthill-McKee so the envelope of L stays
+ * close to the mesh bandwidth, which keeps factorization and the two
+ * triangular solves linear in the number of non-zeros for cloth grids.
+ */
+class SparseCholesky {
+public:
+  struct Entry {
+    int row;
+    int col;
+    float value;
+  };
+
+  /**
+   * @brief Factorize from lower- or upper-triangle entries (duplicates are summed)
+   * @param n Matrix dimension
+   * @param entries Non-zero entries; (i, j) and (j, i) must not both be given
+   * @return false if the matrix is not positive definite
+   */
+  bool factor(int n, const std::vector<Entry> &entries) {
+    size = n;
+    factored = false;
+    if (n == 0) return true;
+
+    // 隣接リストの構築とRCM順序付け
+    std::vector<std::vector<int>> adjacency(n);
+    for (const auto &e : entries) {
+      if (e.row == e.col) continue;
+      adjacency[e.row].push_back(e.col);
+      adjacency[e.col].push_back(e.row);
+    }
+    for (auto &list : adjacency) {
+      std::sort(list.begin(), list.end());
+      list.erase(std::unique(list.begin(), list.end()), list.end());
+    }
+    computeOrdering(adjacency);
+
+    // エンベロープ（各行の最初の非ゼロ列）を決定
+    first.assign(n, 0);
+    for (int i = 0; i < n; ++i) first[i] = i;
+    for (const auto &e : entries) {
+      int r = inverse[e.row], c = inverse[e.col];
+      if (r < c) std::swap(r, c);
+      first[r] = std::min(first[r], c);
+    }
+    rowStart.assign(n + 1, 0);
+    for (int i = 0; i < n; ++i) rowStart[i + 1] = rowStart[i] + (i - first[i] + 1);
+
+    values.assign(rowStart[n], 0.0f);
+    for (const auto &e : entries) {
+      int r = inverse[e.row], c = inverse[e.col];
+      if (r < c) std::swap(r, c);
+      values[rowStart[r] + (c - first[r])] += e.value;
+    }
+
+    // 行指向のエンベロープCholesky分解
+    // (行の開始オフセットは常に first 以上なので、列番号で直接引ける)
+    for (int i = 0; i < n; ++i) {
+      float *Li = values.data() + (rowStart[i] - first[i]);
+      for (int j = first[i]; j <= i; ++j) {
+        const float *Lj = values.data() + (rowStart[j] - first[j]);
+        int k0 = std::max(first[i], first[j]);
+        float s = Li[j];
+        for (int k = k0; k < j; ++k) s -= Li[k] * Lj[k];
+        if (j < i) {
+          Li[j] = s / Lj[j];
+        } else {
+          if (s <= 0.0f) return false;
+          Li[i] = std::sqrt(s);
+        }
+      }
+    }
+
+    scratch.resize(n);
+    factored = true;
+    return true;
+  }
+
+  /**
+   * @brief Solve A x = b in place for three right-hand sides at once
+   */
+  void solve(std::vector<Point3D> &rhs) const {
+    if (!factored) return;
+    for (int i = 0; i < size; ++i) scratch[i] = rhs[order[i]];
+
+    // 前進代入 L y = b
+    for (int i = 0; i < size; ++i) {
+      const float *Li = values.data() + (rowStart[i] - first[i]);
+      Point3D s = scratch[i];
+      for (int k = first[i]; k < i; ++k) s = s - scratch[k] * Li[k];
+      scratch[i] = s * (1.0f / Li[i]);
+    }
+    // 後退代入 L^T x = y（列方向に散布）
+    for (int i = size - 1; i >= 0; --i) {
+      const float *Li = values.data() + (rowStart[i] - first[i]);
+      scratch[i] = scratch[i] * (1.0f / Li[i]);
+      for (int k = first[i]; k < i; ++k) scratch[k] = scratch[k] - scratch[i] * Li[k];
+    }
+
+    for (int i = 0; i < size; ++i) rhs[order[i]] = scratch[i];
+  }
+
+  bool isFactored() const { return factored; }
+  int dimension() const { return size; }
+
+private:
+  /**
+   * 連結成分ごとに最小次数の頂点からBFSしてRCM順序を作る
+   */
+  void computeOrdering(const std::vector<std::vector<int>> &adjacency) {
+    order.clear();
+    order.reserve(size);
+    std::vector<bool> visited(size, false);
+    std::vector<int> byDegree(size);
+    for (int i = 0; i < size; ++i) byDegree[i] = i;
+    std::stable_sort(byDegree.begin(), byDegree.end(), [&](int a, int b) {
+      return adjacency[a].size() < adjacency[b].size();
+    });
+
+    std::vector<int> neighbors;
+    for (int seed : byDegree) {
+      if (visited[seed]) continue;
+      std::queue<int> queue;
+      queue.push(seed);
+      visited[seed] = true;
+      while (!queue.empty()) {
+        int v = queue.front();
+        queue.pop();
+        order.push_back(v);
+        neighbors.clear();
+        for (int w : adjacency[v]) {
+          if (!visited[w]) {
+            visited[w] = true;
+            neighbors.push_back(w);
+          }
+        }
+        std::sort(neighbors.begin(), neighbors.end(), [&](int a, int b) {
+          return adjacency[a].size() < adjacency[b].size();
+        });
+        for (int w : neighbors) queue.push(w);
+      }
+    }
+    std::reverse(order.begin(), order.end());
+
+    inverse.resize(size);
+    for (int i = 0; i < size; ++i) inverse[order[i]] = i;
+  }
+
+  int size = 0;
+  bool factored = false;
+  std::vector<int> order;   // 新しい行 -> 元の行
+  std::vector<int> inverse; // 元の行 -> 新しい行
+  std::vector<int> first;
+  std::vector<int> rowStart;
+  std::vector<float> values;
+  mutable std::vector<Point3D> scratch;
+};
+
+} // namespace arfit
@@ -0,0 +1,141 @@
+/**
+ * @file thread_pool.h
+ * @brief Persistent worker pool with a blocking parallel-for (internal)
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace arfit {
+
+/**
+ * @brief Fixed-size pool of worker threads
+ *
+ * parallelFor() lets the calling thread take chunks too, so it is safe to
+ * call from inside a task running on the pool.
+ */
+class ThreadPool {
+public:
+  /**
+   * @param numThreads Worker count (0 = hardware concurrency - 1)
+   */
+  explicit ThreadPool(size_t numThreads = 0) {
+    if (numThreads == 0) {
+      size_t hw = std::thread::hardware_concurrency();
+      numThreads = hw > 1 ? hw - 1 : 1;
+    }
+    for (size_t i = 0; i < numThreads; ++i) {
+      workers.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    cv.notify_all();
+    for (auto &w : workers) w.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief Process-wide pool shared by the per-frame kernels
+   */
+  static ThreadPool &shared() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  size_t size() const { return workers.size(); }
+
+  /**
+   * @brief Queue a task for asynchronous execution
+   */
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push(std::move(task));
+    }
+    cv.notify_one();
+  }
+
+  /**
+   * @brief Run fn(chunkBegin, chunkEnd) over [begin, end) and wait for completion
+   * @param grain Minimum number of items per chunk
+   */
+  template <typename Fn>
+  void parallelFor(size_t begin, size_t end, size_t grain, Fn &&fn) {
+    if (end <= begin) return;
+    size_t count = end - begin;
+    grain = std::max<size_t>(grain, 1);
+    size_t maxChunks = (workers.size() + 1) * 4;
+    size_t chunkSize = std::max(grain, (count + maxChunks - 1) / maxChunks);
+    size_t numChunks = (count + chunkSize - 1) / chunkSize;
+    if (numChunks <= 1) {
+      fn(begin, end);
+      return;
+    }
+
+    struct Job {
+      std::atomic<size_t> next{0};
+      std::atomic<size_t> done{0};
+      std::mutex mutex;
+      std::condition_variable finished;
+    };
+    auto job = std::make_shared<Job>();
+
+    auto run = [job, begin, end, chunkSize, numChunks, &fn] {
+      size_t chunk;
+      while ((chunk = job->next.fetch_add(1)) < numChunks) {
+        size_t b = begin + chunk * chunkSize;
+        fn(b, std::min(end, b + chunkSize));
+        if (job->done.fetch_add(1) + 1 == numChunks) {
+          std::lock_guard<std::mutex> lock(job->mutex);
+          job->finished.notify_all();
+        }
+      }
+    };
+
+    size_t helpers = std::min(workers.size(), numChunks - 1);
+    for (size_t i = 0; i < helpers; ++i) submit(run);
+    run();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&] { return job->done.load() == numChunks; });
+  }
+
+private:
+  void workerLoop() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+        if (stopping && tasks.empty()) return;
+        task = std::move(tasks.front());
+        tasks.pop();
+      }
+      task();
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::queue<std::function<void()>> tasks;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stopping = false;
+};
+
+} // namespace arfit
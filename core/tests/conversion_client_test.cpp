@@ -0,0 +1,225 @@
+/**
+ * @file conversion_client_test.cpp
+ * @brief ConversionClient against tools/garment_stub_server.py on loopback
+ *
+ * Usage: conversion_client_test <python3> <path to garment_stub_server.py>
+ */
+
+#include "conversion_client.h"
+#include "mesh.h"
+#include "test_check.h"
+#include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace arfit;
+
+namespace {
+
+using GarmentResult = Result<std::shared_ptr<Garment>>;
+
+const int GRID_ROWS = 20;
+const int GRID_COLS = 15;
+
+/**
+ * スタブサーバーを子プロセスとして起動し、破棄時に終了させる
+ */
+class StubServer {
+public:
+  StubServer(const std::string &python, const std::string &script, std::vector<std::string> options) {
+    port = freePort();
+    options.insert(options.begin(), {python, script, "--port", std::to_string(port)});
+    pid = fork();
+    if (pid == 0) {
+      std::vector<char *> argv;
+      for (auto &option : options) argv.push_back(&option[0]);
+      argv.push_back(nullptr);
+      execvp(argv[0], argv.data());
+      _exit(127);
+    }
+    // 待ち受けを始めるまで待つ
+    for (int i = 0; i < 100 && !accepting(); ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+  }
+
+  ~StubServer() {
+    if (pid > 0) {
+      kill(pid, SIGTERM);
+      waitpid(pid, nullptr, 0);
+    }
+  }
+
+  std::string endpoint() const { return "http://127.0.0.1:" + std::to_string(port) + "/api"; }
+
+  bool accepting() const {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = loopback(port);
+    bool ok = ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+    close(fd);
+    return ok;
+  }
+
+private:
+  pid_t pid = -1;
+  int port = 0;
+
+  static sockaddr_in loopback(int port) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return address;
+  }
+
+  // 空いているポートをOSに選ばせる
+  static int freePort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = loopback(0);
+    bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+    close(fd);
+    return ntohs(address.sin_port);
+  }
+};
+
+/**
+ * コールバックの結果を集めて、指定数そろうまで待つ
+ */
+class Results {
+public:
+  ConversionCallback callback(int index) {
+    return [this, index](const GarmentResult &result) {
+      std::lock_guard<std::mutex> lock(mutex);
+      results.resize(std::max(results.size(), (size_t)index + 1));
+      results[index] = result;
+      ++completed;
+      changed.notify_all();
+    };
+  }
+
+  bool waitFor(int count, int timeoutMs = 10000) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), [&] { return completed >= count; });
+  }
+
+  GarmentResult get(int index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < (int)results.size() ? results[index] : GarmentResult{};
+  }
+
+private:
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::vector<GarmentResult> results;
+  int completed = 0;
+};
+
+bool isGridGarment(const GarmentResult &result) {
+  return result.isSuccess() && result.value && result.value->getMesh() &&
+         result.value->getMesh()->getVertexCount() == (size_t)(GRID_ROWS * GRID_COLS);
+}
+
+// 同じURLへの同時要求は1回のサーバー要求にまとめられ、同じ衣服を受け取る
+void testCoalescing(const std::string &python, const std::string &script) {
+  StubServer server(python, script, {"--delay", "0.3"});
+  CHECK(server.accepting());
+
+  ConversionClientConfig config;
+  config.endpoint = server.endpoint();
+  ConversionClient client(config);
+  Results results;
+  client.convert("https://example.com/shirt.png", results.callback(0));
+  client.convert("https://example.com/shirt.png", results.callback(1));
+  client.convert("https://example.com/shirt.png", results.callback(2));
+  client.convert("https://example.com/pants.png", results.callback(3));
+  CHECK(results.waitFor(4));
+
+  for (int i = 0; i < 4; ++i) CHECK(isGridGarment(results.get(i)));
+  CHECK(results.get(0).value == results.get(1).value);
+  CHECK(results.get(0).value == results.get(2).value);
+  CHECK(results.get(0).value != results.get(3).value);
+
+  ConversionClientStats stats = client.getStats();
+  CHECK(stats.requests == 4);
+  CHECK(stats.coalesced == 2);
+  CHECK(stats.serverRequests == 2);
+}
+
+// 逐次の要求は1本の接続を使い回し、chunked 形式の応答も組み立てられる
+void testKeepAliveChunked(const std::string &python, const std::string &script) {
+  StubServer server(python, script, {"--chunked", "--chunk-size", "1000"});
+  CHECK(server.accepting());
+
+  ConversionClientConfig config;
+  config.endpoint = server.endpoint();
+  config.maxConnections = 1;
+  ConversionClient client(config);
+  Results results;
+  const int count = 3;
+  for (int i = 0; i < count; ++i) {
+    client.convert("https://example.com/item" + std::to_string(i) + ".png", results.callback(i));
+    CHECK(results.waitFor(i + 1));
+    CHECK(isGridGarment(results.get(i)));
+  }
+
+  ConversionClientStats stats = client.getStats();
+  CHECK(stats.serverRequests == (uint64_t)count);
+  CHECK(stats.connectionsOpened == 1);
+}
+
+// 処理中（使い回した接続上）と待ち行列の要求は、破棄時に停止として完了する
+void testCancel(const std::string &python, const std::string &script) {
+  StubServer server(python, script, {"--delay", "1.0"});
+  CHECK(server.accepting());
+
+  Results results;
+  {
+    ConversionClientConfig config;
+    config.endpoint = server.endpoint();
+    config.maxConnections = 1;
+    ConversionClient client(config);
+
+    // 1件目で接続を確立しておき、2件目はその接続を使い回す
+    client.convert("https://example.com/first.png", results.callback(0));
+    CHECK(results.waitFor(1));
+    CHECK(isGridGarment(results.get(0)));
+
+    client.convert("https://example.com/in-flight.png", results.callback(1));
+    client.convert("https://example.com/queued.png", results.callback(2));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    CHECK(client.getStats().serverRequests == 2);
+  }
+
+  // デストラクタが戻る前にすべて通知されている
+  CHECK(results.waitFor(3, 0));
+  for (int i = 1; i < 3; ++i) {
+    GarmentResult result = results.get(i);
+    CHECK(result.error == ErrorCode::NETWORK_ERROR);
+    CHECK(result.message == "Conversion client stopped");
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    std::fprintf(stderr, "usage: %s <python3> <garment_stub_server.py>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  testCoalescing(argv[1], argv[2]);
+  testKeepAliveChunked(argv[1], argv[2]);
+  testCancel(argv[1], argv[2]);
+  return TEST_RESULT();
+}
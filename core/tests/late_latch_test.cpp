@@ -0,0 +1,115 @@
+/**
+ * @file late_latch_test.cpp
+ * @brief Late-latch corrections compare the latched pose on the prediction's time base
+ */
+
+#include "ar_renderer.h"
+#include "garment_converter.h"
+#include "mesh.h"
+#include "test_check.h"
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace arfit;
+
+namespace {
+
+const int SIZE = 64;
+
+// ランドマーク0に全重みを持つ正方形の衣服
+std::shared_ptr<Garment> makeGarment() {
+  std::vector<Vertex> vertices(4);
+  const float corners[4][2] = {{-0.3f, -0.3f}, {0.3f, -0.3f}, {0.3f, 0.3f}, {-0.3f, 0.3f}};
+  for (int i = 0; i < 4; ++i) {
+    vertices[i].position = {corners[i][0], corners[i][1], 0.0f};
+    vertices[i].normal = {0.0f, 0.0f, 1.0f};
+  }
+  auto mesh = std::make_shared<Mesh>();
+  mesh->setVertices(vertices);
+  mesh->setFaces({{{0, 1, 2}}, {{0, 2, 3}}});
+
+  auto garment = std::make_shared<Garment>();
+  garment->setMesh(mesh);
+  garment->setBoneWeights(std::vector<std::vector<Garment::BoneWeight>>(4, {{0, 1.0f}}));
+  return garment;
+}
+
+BodyPose poseAt(float x) {
+  BodyPose pose;
+  for (auto &landmark : pose.landmarks) landmark = {x, 0.0f, 0.0f};
+  pose.visibility.fill(1.0f);
+  return pose;
+}
+
+// 描画された衣服の画素の重心（x、ピクセル）
+float garmentCentroidX(ARRenderer &renderer) {
+  auto image = renderer.render();
+  double sum = 0.0;
+  int count = 0;
+  for (int y = 0; y < image.value.height; ++y) {
+    for (int x = 0; x < image.value.width; ++x) {
+      if (image.value.pixels[(y * image.value.width + x) * 4] != 0) {
+        sum += x;
+        ++count;
+      }
+    }
+  }
+  return count > 0 ? (float)(sum / count) : -1.0f;
+}
+
+} // namespace
+
+int main() {
+  ARRenderer renderer;
+  renderer.initialize();
+
+  CameraFrame frame;
+  frame.image.width = SIZE;
+  frame.image.height = SIZE;
+  frame.image.channels = 4;
+  frame.image.pixels.assign(SIZE * SIZE * 4, 0);
+  renderer.setCameraFrame(frame);
+
+  auto garment = makeGarment();
+  std::vector<Point3D> positions;
+  for (const auto &vertex : garment->getMesh()->getVertices()) positions.push_back(vertex.position);
+  renderer.addGarment(garment, positions);
+
+  auto latch = std::make_shared<PoseLatch>();
+  renderer.setPoseLatch(latch);
+
+  // 右へ 1 単位/秒で動いている: t=1.0 の実測から表示時刻 t=1.05 へ予測した姿勢でシミュレーション
+  const float captureTime = 1.0f, displayTime = 1.05f;
+  renderer.setSimulationPose(poseAt(0.0f), captureTime, poseAt(0.05f), displayTime);
+
+  float baseline = garmentCentroidX(renderer); // 新しい姿勢が無ければ補正しない
+  CHECK(baseline > 0.0f);
+
+  // 撮影時刻が実測と同じ姿勢は新しい情報を持たない
+  latch->publish(poseAt(0.0f), captureTime);
+  CHECK(std::abs(garmentCentroidX(renderer) - baseline) < 0.5f);
+
+  // 予測どおりに動いた姿勢は、表示時刻への外挿が予測姿勢と一致するので補正なし
+  // （旧実装は撮影時刻を表示時刻と比べていたため、この時刻の姿勢を常に捨てていた）
+  latch->publish(poseAt(0.033f), 1.033f);
+  CHECK(std::abs(garmentCentroidX(renderer) - baseline) < 0.5f);
+
+  // 予測より 0.1 先へ動いていれば、その分（64px 幅で 3.2px）右へ補正する
+  latch->publish(poseAt(0.133f), 1.034f);
+  float shifted = garmentCentroidX(renderer);
+  CHECK(shifted - baseline > 2.5f && shifted - baseline < 4.0f);
+
+  // 表示時刻より後の姿勢はそのまま予測姿勢と比べる（止まった場合は行き過ぎを戻す）
+  latch->publish(poseAt(0.0f), 1.1f);
+  float stopped = garmentCentroidX(renderer);
+  CHECK(baseline - stopped > 1.0f && baseline - stopped < 2.5f);
+
+  // 予測なし（実測と同じ姿勢でシミュレーション）では最新姿勢との差をそのまま使う
+  renderer.setSimulationPose(poseAt(0.0f), 2.0f);
+  latch->publish(poseAt(0.1f), 2.033f);
+  float unpredicted = garmentCentroidX(renderer);
+  CHECK(unpredicted - baseline > 2.5f && unpredicted - baseline < 4.0f);
+
+  return TEST_RESULT();
+}
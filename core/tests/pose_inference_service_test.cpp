@@ -0,0 +1,133 @@
+/**
+ * @file pose_inference_service_test.cpp
+ * @brief Batched inference through PoseInferenceService matches ReferencePoseEstimator
+ */
+
+#include "pose_inference_service.h"
+#include "test_check.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace arfit;
+
+namespace {
+
+const int NUM_SESSIONS = 4;
+const int NUM_FRAMES = 8;
+
+// セッションごとに異なる時刻・切り出し位置の入力を書き込む
+void fillInput(PoseInputTensor &tensor, int session, int frame) {
+  tensor.timestamp = frame / 30.0f + session * 0.37f;
+  tensor.transform = LetterboxTransform();
+  tensor.transform.tensorWidth = tensor.width;
+  tensor.transform.tensorHeight = tensor.height;
+  tensor.transform.sourceWidth = 640;
+  tensor.transform.sourceHeight = 480;
+  tensor.transform.cropOrigin = {10.0f * session, 5.0f * session};
+  tensor.transform.scale = tensor.width / 640.0f;
+  tensor.transform.pad = {0.0f, (tensor.height - 480.0f * tensor.transform.scale) * 0.5f};
+}
+
+bool samePoses(const std::vector<BodyPose> &a, const std::vector<BodyPose> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t p = 0; p < a.size(); ++p) {
+    if (a[p].confidence != b[p].confidence || a[p].visibility != b[p].visibility) return false;
+    for (size_t i = 0; i < a[p].landmarks.size(); ++i) {
+      const Point3D &u = a[p].landmarks[i], &v = b[p].landmarks[i];
+      if (u.x != v.x || u.y != v.y || u.z != v.z) return false;
+    }
+  }
+  return true;
+}
+
+// 全セッションが揃ってから同時に投入させる
+class StartGate {
+public:
+  explicit StartGate(int count) : count(count), remaining(count) {}
+
+  void arriveAndWait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (--remaining == 0) {
+      ++generation;
+      remaining = count;
+      released.notify_all();
+      return;
+    }
+    int current = generation;
+    released.wait(lock, [&] { return generation != current; });
+  }
+
+private:
+  std::mutex mutex;
+  std::condition_variable released;
+  const int count;
+  int remaining;
+  int generation = 0;
+};
+
+} // namespace
+
+int main() {
+  PoseInferenceServiceConfig config;
+  config.estimator.maxPoses = 2;
+  config.maxBatchSize = NUM_SESSIONS;
+  config.maxBatchDelayMs = 50.0f; // 同時投入が確実に1バッチにまとまるよう長めに待つ
+
+  PoseInferenceService service(config);
+  ReferencePoseEstimator reference(config.estimator);
+
+  std::vector<std::vector<std::vector<BodyPose>>> batched(NUM_SESSIONS);
+  std::vector<char> completed(NUM_SESSIONS * NUM_FRAMES, 0);
+  StartGate gate(NUM_SESSIONS);
+
+  std::vector<std::thread> threads;
+  for (int s = 0; s < NUM_SESSIONS; ++s) {
+    threads.emplace_back([&, s] {
+      auto session = service.createSession();
+      for (int f = 0; f < NUM_FRAMES; ++f) {
+        fillInput(session->acquireInput(), s, f);
+        gate.arriveAndWait();
+        uint64_t ticket = session->submit();
+        std::vector<BodyPose> poses;
+        completed[s * NUM_FRAMES + f] = session->wait(ticket, poses);
+        batched[s].push_back(std::move(poses));
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+
+  // 同じ入力を単体の推定器に通した結果と一致すること
+  for (int s = 0; s < NUM_SESSIONS; ++s) {
+    for (int f = 0; f < NUM_FRAMES; ++f) {
+      CHECK(completed[s * NUM_FRAMES + f]);
+      fillInput(reference.acquireInput(), s, f);
+      uint64_t ticket = reference.submit();
+      std::vector<BodyPose> expected;
+      CHECK(reference.wait(ticket, expected));
+      CHECK(expected.size() == (size_t)config.estimator.maxPoses);
+      CHECK(samePoses(batched[s][f], expected));
+    }
+  }
+
+  PoseInferenceStats stats = service.getStats();
+  CHECK(stats.requests == (uint64_t)(NUM_SESSIONS * NUM_FRAMES));
+  CHECK(stats.meanBatchSize > 1.0f);
+
+  // 最新2件より前のチケットは保持されない
+  auto session = service.createSession();
+  uint64_t first = 0;
+  for (int f = 0; f < 3; ++f) {
+    fillInput(session->acquireInput(), 0, f);
+    uint64_t ticket = session->submit();
+    if (f == 0) first = ticket;
+    std::vector<BodyPose> poses;
+    CHECK(session->wait(ticket, poses));
+  }
+  std::vector<BodyPose> stale;
+  CHECK(!session->poll(first, stale));
+  CHECK(!session->wait(first, stale));
+
+  return TEST_RESULT();
+}
@@ -0,0 +1,25 @@
+/**
+ * @file test_check.h
+ * @brief Minimal assertion helpers for the unit tests
+ */
+
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+// 失敗しても続行し、最後に失敗数を終了コードで返す
+inline int &arfitTestFailures() {
+  static int failures = 0;
+  return failures;
+}
+
+#define CHECK(condition)                                                              \
+  do {                                                                                \
+    if (!(condition)) {                                                               \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      ++arfitTestFailures();                                                          \
+    }                                                                                 \
+  } while (0)
+
+#define TEST_RESULT() (arfitTestFailures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE)
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""
+Convert an SMPL model pickle (e.g. basicModel_neutral_lbs_10_207_0_v1.0.0.pkl)
+into the ARFit-Kit binary model format loaded by arfit::SMPLModel::load.
+
+The layout is described in core/include/smpl_model.h. Every array is written
+exactly as the runtime consumes it (SoA planes padded to a multiple of four
+vertices, 64-byte aligned sections) so that loading is a single mmap.
+
+Usage:
+    python3 tools/convert_smpl.py SMPL_NEUTRAL.pkl ml-models/smpl_neutral.arfsmpl
+"""
+
+import argparse
+import pickle
+import struct
+import sys
+
+import numpy as np
+
+MAGIC = b"ARFSMPL\0"
+VERSION = 1
+ALIGNMENT = 64
+NUM_VERTICES = 6890
+NUM_JOINTS = 24
+NUM_BETAS = 10
+NUM_POSE_FEATURES = (NUM_JOINTS - 1) * 9
+SECTION_COUNT = 9
+
+
+def to_array(value, dtype):
+    # chumpy配列は .r で実体を取り出す
+    if hasattr(value, "r"):
+        value = value.r
+    if hasattr(value, "toarray"):
+        value = value.toarray()
+    return np.ascontiguousarray(np.asarray(value), dtype=dtype)
+
+
+def planes(vertices, padded):
+    """(V, 3) -> (3, padded) SoA planes"""
+    out = np.zeros((3, padded), dtype=np.float32)
+    out[:, : vertices.shape[0]] = vertices.T
+    return out
+
+
+def regressor_csr(regressor):
+    if hasattr(regressor, "tocsr"):
+        csr = regressor.tocsr()
+        csr.eliminate_zeros()
+        return (csr.indptr.astype(np.int32), csr.indices.astype(np.int32),
+                csr.data.astype(np.float32))
+    dense = to_array(regressor, np.float32)
+    rows, vertices, weights = [0], [], []
+    for row in dense:
+        nz = np.nonzero(row)[0]
+        vertices.extend(nz)
+        weights.extend(row[nz])
+        rows.append(len(vertices))
+    return (np.array(rows, dtype=np.int32), np.array(vertices, dtype=np.int32),
+            np.array(weights, dtype=np.float32))
+
+
+def convert(model, padded):
+    template = to_array(model["v_template"], np.float32)
+    shapedirs = to_array(model["shapedirs"], np.float32)[:, :, :NUM_BETAS]
+    posedirs = to_array(model["posedirs"], np.float32)
+    weights = to_array(model["weights"], np.float32)
+    parents = to_array(model["kintree_table"], np.int64)[0].astype(np.int32)
+    parents[0] = -1
+
+    if template.shape != (NUM_VERTICES, 3):
+        raise ValueError("unexpected v_template shape %s" % (template.shape,))
+    if posedirs.shape != (NUM_VERTICES, 3, NUM_POSE_FEATURES):
+        raise ValueError("unexpected posedirs shape %s" % (posedirs.shape,))
+    if weights.shape != (NUM_VERTICES, NUM_JOINTS):
+        raise ValueError("unexpected weights shape %s" % (weights.shape,))
+
+    shape_planes = np.zeros((NUM_BETAS, 3, padded), dtype=np.float32)
+    shape_planes[:, :, :NUM_VERTICES] = shapedirs.transpose(2, 1, 0)
+    pose_planes = np.zeros((NUM_POSE_FEATURES, 3, padded), dtype=np.float32)
+    pose_planes[:, :, :NUM_VERTICES] = posedirs.transpose(2, 1, 0)
+    weight_planes = np.zeros((NUM_JOINTS, padded), dtype=np.float32)
+    weight_planes[:, :NUM_VERTICES] = weights.T
+
+    # 4頂点グループごとに影響する関節のビットマスク
+    influence = (weight_planes != 0.0).reshape(NUM_JOINTS, padded // 4, 4).any(axis=2)
+    masks = np.zeros(padded // 4, dtype=np.uint32)
+    for j in range(NUM_JOINTS):
+        masks |= influence[j].astype(np.uint32) << np.uint32(j)
+
+    rows, vertex, weight = regressor_csr(model["J_regressor"])
+
+    return [
+        planes(template, padded),
+        shape_planes,
+        pose_planes,
+        weight_planes,
+        parents,
+        rows,
+        vertex,
+        weight,
+        masks,
+    ], len(vertex)
+
+
+def align(offset):
+    return (offset + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+
+def write(path, sections, nonzeros, padded):
+    header = struct.pack("<8s8I24x", MAGIC, VERSION, NUM_VERTICES, padded, NUM_JOINTS,
+                         NUM_BETAS, NUM_POSE_FEATURES, nonzeros, SECTION_COUNT)
+    table_size = SECTION_COUNT * 16
+    offset = align(len(header) + table_size)
+    table = []
+    for array in sections:
+        table.append((offset, array.nbytes))
+        offset = align(offset + array.nbytes)
+
+    with open(path, "wb") as f:
+        f.write(header)
+        for entry in table:
+            f.write(struct.pack("<QQ", *entry))
+        for (start, _), array in zip(table, sections):
+            f.write(b"\0" * (start - f.tell()))
+            f.write(array.astype(array.dtype.newbyteorder("<"), copy=False).tobytes())
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="SMPL model .pkl")
+    parser.add_argument("output", help="binary model to write")
+    args = parser.parse_args()
+
+    with open(args.input, "rb") as f:
+        model = pickle.load(f, encoding="latin1")
+
+    padded = (NUM_VERTICES + 3) & ~3
+    try:
+        sections, nonzeros = convert(model, padded)
+    except (KeyError, ValueError) as e:
+        print("error: %s" % e, file=sys.stderr)
+        return 1
+    write(args.output, sections, nonzeros, padded)
+    print("wrote %s" % args.output)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
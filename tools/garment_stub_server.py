@@ -0,0 +1,176 @@
+#!/usr/bin/env python3
+"""
+Loopback stub for the hybrid garment conversion server, for exercising
+arfit::ConversionClient without the real backend.
+
+Answers `GET <path>/convert?url=<image URL>` over HTTP/1.1 keep-alive with a
+garment in the ARFit garment binary format (core/src/garment_blob.h): either a
+blob read from disk (e.g. a file from the garment cache directory) or a
+generated grid garment. The image URL is not fetched.
+
+Usage:
+    python3 tools/garment_stub_server.py --port 8765
+    python3 tools/garment_stub_server.py --port 8765 --chunked --delay 0.2
+    python3 tools/garment_stub_server.py --blob ~/cache/0123456789abcdef.garment
+
+Then point SessionConfig::serverEndpoint at http://127.0.0.1:8765.
+"""
+
+import argparse
+import struct
+import sys
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlsplit
+
+MAGIC = b"ARFGARM\0"
+VERSION = 1
+ALIGNMENT = 64
+SECTION_COUNT = 7
+HAS_MESH = 1 << 0
+HAS_TEXTURE = 1 << 1
+TSHIRT = 0
+
+
+def align(offset):
+    return (offset + ALIGNMENT - 1) // ALIGNMENT * ALIGNMENT
+
+
+def grid_garment(rows, cols, texture_size):
+    """Flat rows x cols garment with one bone per vertex and edge springs."""
+    vertices, uvs, weights, rows_csr = [], [], [], [0]
+    for r in range(rows):
+        for c in range(cols):
+            u, v = c / (cols - 1), r / (rows - 1)
+            # position, normal, texCoord, tangent, bitangent
+            vertices.append(struct.pack("<14f", u - 0.5, 0.5 - v, 0.0, 0, 0, 1, u, v, 1, 0, 0, 0, 1, 0))
+            uvs.append(struct.pack("<2f", u, v))
+            weights.append(struct.pack("<if", 0, 1.0))
+            rows_csr.append(len(weights))
+
+    faces, constraints = [], []
+    for r in range(rows):
+        for c in range(cols):
+            i = r * cols + c
+            if c + 1 < cols:
+                constraints.append(struct.pack("<iiff", i, i + 1, 1.0 / (cols - 1), 1.0))
+            if r + 1 < rows:
+                constraints.append(struct.pack("<iiff", i, i + cols, 1.0 / (rows - 1), 1.0))
+            if r + 1 < rows and c + 1 < cols:
+                faces.append(struct.pack("<3I", i, i + cols, i + 1))
+                faces.append(struct.pack("<3I", i + 1, i + cols, i + cols + 1))
+
+    texels = bytes((200, 60, 60, 255)) * (texture_size * texture_size)
+    payloads = [
+        b"".join(vertices),
+        b"".join(faces),
+        b"".join(uvs),
+        struct.pack("<%dI" % len(rows_csr), *rows_csr),
+        b"".join(weights),
+        b"".join(constraints),
+        texels,
+    ]
+
+    header = MAGIC + struct.pack(
+        "<IIQiIIIIIIIiiiI",
+        VERSION, SECTION_COUNT, 0, TSHIRT, HAS_MESH | HAS_TEXTURE,
+        len(vertices), len(faces), len(uvs), len(rows_csr) - 1, len(weights), len(constraints),
+        texture_size, texture_size, 4, 0)
+    assert len(header) == 72
+
+    table, body = [], b""
+    offset = len(header) + 16 * SECTION_COUNT
+    for payload in payloads:
+        offset = align(offset)
+        table.append(struct.pack("<QQ", offset, len(payload)))
+        offset += len(payload)
+
+    blob = bytearray(header + b"".join(table))
+    for payload, entry in zip(payloads, table):
+        start, _ = struct.unpack("<QQ", entry)
+        blob.extend(b"\0" * (start - len(blob)))
+        blob.extend(payload)
+    return bytes(blob)
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # keep-alive
+
+    def do_GET(self):
+        parts = urlsplit(self.path)
+        query = parse_qs(parts.query)
+        if not parts.path.endswith("/convert") or "url" not in query:
+            self.reply_error(404, "unknown request")
+            return
+
+        with self.server.lock:
+            self.server.requests += 1
+            count = self.server.requests
+        print("[%d] convert %s" % (count, query["url"][0]), file=sys.stderr)
+        if self.server.delay > 0:
+            time.sleep(self.server.delay)
+
+        blob = self.server.blob
+        self.send_response(200)
+        self.send_header("Content-Type", "application/x-arfit-garment")
+        if self.server.chunked:
+            self.send_header("Transfer-Encoding", "chunked")
+            self.end_headers()
+            for start in range(0, len(blob), self.server.chunk_size):
+                chunk = blob[start:start + self.server.chunk_size]
+                self.wfile.write(b"%x\r\n%s\r\n" % (len(chunk), chunk))
+            self.wfile.write(b"0\r\n\r\n")
+        else:
+            self.send_header("Content-Length", str(len(blob)))
+            self.end_headers()
+            self.wfile.write(blob)
+
+    def reply_error(self, status, message):
+        body = message.encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "text/plain")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def log_message(self, format, *args):
+        pass
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8765)
+    parser.add_argument("--blob", help="serve this garment blob instead of a generated grid")
+    parser.add_argument("--grid", type=int, nargs=2, default=(20, 15), metavar=("ROWS", "COLS"))
+    parser.add_argument("--texture-size", type=int, default=512)
+    parser.add_argument("--chunked", action="store_true", help="use chunked transfer encoding")
+    parser.add_argument("--chunk-size", type=int, default=16 * 1024)
+    parser.add_argument("--delay", type=float, default=0.0, help="seconds to wait before each response")
+    args = parser.parse_args()
+
+    if args.blob:
+        with open(args.blob, "rb") as f:
+            blob = f.read()
+        if blob[:8] != MAGIC:
+            sys.exit("%s is not a garment blob" % args.blob)
+    else:
+        blob = grid_garment(args.grid[0], args.grid[1], args.texture_size)
+
+    server = ThreadingHTTPServer((args.host, args.port), Handler)
+    server.blob = blob
+    server.chunked = args.chunked
+    server.chunk_size = args.chunk_size
+    server.delay = args.delay
+    server.requests = 0
+    server.lock = threading.Lock()
+    print("serving %d-byte garment on http://%s:%d" % (len(blob), args.host, args.port), file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()